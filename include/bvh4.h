@@ -0,0 +1,423 @@
+#ifndef BVH4_H
+#define BVH4_H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include "bvh.hcu"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define BVH4_USE_SSE
+#endif
+
+// host copies of the collision solver's constants (the device ones live in constant memory)
+const float HOST_EPS = 10e-4f;
+const float HOST_MAX_SCENE_BOUNDS = 50.0f;
+const float HOST_CLOTH_THICKNESS = 0.03f;
+
+const int BVH4_EMPTY_CHILD = 0x7fffffff;
+const float BVH4_FAR_BOUND = 1e30f; // bounds of empty children: a degenerate box no ray can reach
+
+struct alignas(16) BVH4Node
+{
+    /**
+     * 4-wide node, child bounds stored as SoA so that one SIMD slab test checks all children at once
+    */
+    float minX[4];
+    float minY[4];
+    float minZ[4];
+    float maxX[4];
+    float maxY[4];
+    float maxZ[4];
+
+    // >= 0 : index of the child BVH4 node, < 0 : leaf (~index of its first triangle), BVH4_EMPTY_CHILD : no child
+    int children[4];
+    int triCount[4]; // number of triangles of leaf children
+};
+
+struct RayHit
+{
+    int triIdx; // index in the original list of triangles (-1 : no hit)
+    glm::vec4 hitInfo; // intersection point && distance (same convention as the GPU solver)
+};
+
+struct RayQueryStats
+{
+    unsigned long long queries;
+    unsigned long long nodesVisited;
+    unsigned long long trianglesTested;
+};
+
+inline bool hostIntersectSegmentTriangle(glm::vec3 origin, glm::vec3 dir, const HotTriangle &tri, glm::vec4 *hitPtInfos)
+{
+    /**
+     * Host version of intersectSegmentHotTriangle (see collisions_solver.hcu)
+    */
+    glm::vec3 qp = -dir;
+    glm::vec3 p0 = glm::vec3(tri.p0);
+    glm::vec3 ab = glm::vec3(tri.e1);
+    glm::vec3 ac = glm::vec3(tri.e2);
+    glm::vec3 n = cross(ab, ac);
+
+    float det = dot(qp, n);
+    glm::vec3 ap = origin - p0;
+    float t = dot(ap, n);
+
+    if (det > 10e-6 && t < 10e-6) return false;
+    if (det <= HOST_EPS) return false;
+
+    glm::vec2 limits = glm::vec2(0.01f, 0.9f)*HOST_CLOTH_THICKNESS*det;
+    if (t < limits.x || t > limits.y || std::abs(t) >= std::abs((*hitPtInfos).w)) return false;
+
+    glm::vec3 e = cross(qp, ap);
+    float v = dot(ac, e);
+    if (v/det < -HOST_EPS || v - det > HOST_EPS) return false;
+
+    float w = -dot(ab, e);
+    if (w/det < -HOST_EPS || w - det > HOST_EPS) return false;
+
+    float u = det - v - w;
+    if (u/det < -HOST_EPS) return false;
+
+    *hitPtInfos = glm::vec4(p0*det + ab*v + ac*w + t*qp, t)/det;
+    return true;
+}
+
+inline bool hostIntersectRayAABB(glm::vec3 origin, glm::vec3 dir, glm::vec3 bbmin, glm::vec3 bbmax, float *tNear)
+{
+    /**
+     * Host version of intersectRayAABB (scalar slab test, used by the binary tree traversal)
+    */
+    float tNewNear = 0.0f;
+    float tFar = 100.0f;
+    for (int i = 0; i<3; ++i)
+    {
+        if (std::abs(dir[i]) < HOST_EPS)
+        {
+            if (origin[i] < bbmin[i] || origin[i] > bbmax[i]) return false;
+        }
+        else
+        {
+            float s0 = (bbmin[i] - origin[i])/dir[i];
+            float s1 = (bbmax[i] - origin[i])/dir[i];
+            tNewNear = std::max(tNewNear, std::min(s0, s1));
+            tFar = std::min(tFar, std::max(s0, s1));
+            if (tNewNear > tFar) return false;
+        }
+    }
+    *tNear = tNewNear;
+    return true;
+}
+
+#ifdef BVH4_USE_SSE
+inline void slabTest4(const float *bmin, const float *bmax, __m128 o, __m128 inv, bool isParallel, __m128 &tMin, __m128 &tMax, 
+    __m128 &inside)
+{
+    /**
+     * One axis of the 4-wide slab test. On an axis parallel to the ray (same threshold as hostIntersectRayAABB), 1/dir
+     * would give 0*inf = NaN for boxes with a face through the origin : the boxes have to hold the origin instead.
+    */
+    __m128 lo = _mm_load_ps(bmin);
+    __m128 hi = _mm_load_ps(bmax);
+    if (isParallel)
+    {
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(o, lo), _mm_cmple_ps(o, hi)));
+        return;
+    }
+    __m128 t0 = _mm_mul_ps(_mm_sub_ps(lo, o), inv);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(hi, o), inv);
+    tMin = _mm_max_ps(tMin, _mm_min_ps(t0, t1));
+    tMax = _mm_min_ps(tMax, _mm_max_ps(t0, t1));
+}
+#endif
+
+class BVH4
+{
+    public:
+
+    BVH4(BVH *bvh) : m_bvh(bvh)
+    {
+        /**
+         * Builds a 4-wide BVH by collapsing the given binary tree : each 4-wide node adopts the grand-children
+         * of its largest internal children until it has 4 children.
+        */
+        auto start = std::chrono::steady_clock::now();
+
+        m_triangles.reserve(bvh->getNbTri());
+        collapse(std::vector<int>(1, 0));
+
+        std::chrono::duration<double> elapsed_seconds = std::chrono::steady_clock::now() - start;
+        printf("BVH4 with %i nodes (binary tree : %i nodes) collapsed in %f\n", (int) m_nodes.size(), bvh->getNbNodes(), (float) elapsed_seconds.count());
+    }
+
+    int getNbNodes() {return m_nodes.size();};
+    size_t memory() {return m_nodes.size()*sizeof(BVH4Node) + m_triangles.size()*sizeof(HotTriangle);};
+
+    void intersect(glm::vec3 origin, glm::vec3 dir, RayHit &hit, RayQueryStats &stats) const
+    {
+        /**
+         * Closest hit of the given segment (same semantic as collisionDetection) using 4-wide SIMD box tests
+        */
+        int stack[MAX_STACK_SIZE_4];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+#ifdef BVH4_USE_SSE
+        const __m128 ox = _mm_set1_ps(origin.x);
+        const __m128 oy = _mm_set1_ps(origin.y);
+        const __m128 oz = _mm_set1_ps(origin.z);
+        const __m128 invX = _mm_set1_ps(1.0f/dir.x);
+        const __m128 invY = _mm_set1_ps(1.0f/dir.y);
+        const __m128 invZ = _mm_set1_ps(1.0f/dir.z);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 farV = _mm_set1_ps(HOST_MAX_SCENE_BOUNDS);
+        const __m128 allLanes = _mm_cmpeq_ps(zero, zero);
+#else
+        const glm::vec3 inv = 1.0f/dir;
+#endif
+        const bool isParallel[3] = {std::abs(dir.x) < HOST_EPS, std::abs(dir.y) < HOST_EPS, std::abs(dir.z) < HOST_EPS};
+
+        while (stackSize != 0)
+        {
+            const BVH4Node &node = m_nodes[stack[--stackSize]];
+            stats.nodesVisited++;
+
+            int mask = 0;
+#ifdef BVH4_USE_SSE
+            __m128 tMin = zero;
+            __m128 tMax = farV;
+            __m128 inside = allLanes;
+            slabTest4(node.minX, node.maxX, ox, invX, isParallel[0], tMin, tMax, inside);
+            slabTest4(node.minY, node.maxY, oy, invY, isParallel[1], tMin, tMax, inside);
+            slabTest4(node.minZ, node.maxZ, oz, invZ, isParallel[2], tMin, tMax, inside);
+            mask = _mm_movemask_ps(_mm_and_ps(inside, _mm_cmple_ps(tMin, tMax)));
+#else
+            for (int c = 0; c<4; ++c)
+            {
+                float tMin = 0.0f;
+                float tMax = HOST_MAX_SCENE_BOUNDS;
+                float bmin[3] = {node.minX[c], node.minY[c], node.minZ[c]};
+                float bmax[3] = {node.maxX[c], node.maxY[c], node.maxZ[c]};
+                for (int k = 0; k<3; ++k)
+                {
+                    if (isParallel[k])
+                    {
+                        if (origin[k] < bmin[k] || origin[k] > bmax[k]) tMin = HOST_MAX_SCENE_BOUNDS*2.0f;
+                        continue;
+                    }
+                    float s0 = (bmin[k] - origin[k])*inv[k];
+                    float s1 = (bmax[k] - origin[k])*inv[k];
+                    tMin = std::max(tMin, std::min(s0, s1));
+                    tMax = std::min(tMax, std::max(s0, s1));
+                }
+                if (tMin <= tMax) mask |= 1 << c;
+            }
+#endif
+            for (int c = 0; c<4; ++c)
+            {
+                if (!(mask & (1 << c))) continue;
+
+                int child = node.children[c];
+                if (child == BVH4_EMPTY_CHILD) continue;
+                if (child >= 0)
+                {
+                    stack[stackSize++] = child;
+                    continue;
+                }
+
+                // leaf -> narrow phase
+                int first = ~child;
+                for (int k = first; k < first + node.triCount[c]; ++k)
+                {
+                    const HotTriangle &tri = m_triangles[k];
+                    stats.trianglesTested++;
+                    if (hostIntersectSegmentTriangle(origin, dir, tri, &hit.hitInfo))
+                    {
+                        int triIdx;
+                        memcpy(&triIdx, &tri.p0.w, sizeof(int));
+                        hit.triIdx = triIdx;
+                    }
+                }
+            }
+        }
+        stats.queries++;
+    }
+
+    private:
+
+    static const int MAX_STACK_SIZE_4 = 128;
+
+    BVH *m_bvh;
+    std::vector<BVH4Node> m_nodes;
+    std::vector<HotTriangle> m_triangles; // leaf triangles, stored contiguously in depth-first leaf order
+
+    int collapse(std::vector<int> slots)
+    {
+        /**
+         * Creates the 4-wide node whose children are the given binary nodes (opened until there are 4 of them)
+        */
+        Node *tree = m_bvh->getTree();
+
+        while (slots.size() < 4)
+        {
+            int best = -1;
+            float bestArea = -1.0f;
+            for (int k = 0; k < (int) slots.size(); ++k)
+            {
+                Node &node = tree[slots[k]];
+                if (node.triCount == 0 && node.aabb.area() > bestArea)
+                {
+                    best = k;
+                    bestArea = node.aabb.area();
+                }
+            }
+            if (best < 0) break; // only leaves left
+
+            int opened = slots[best];
+            slots[best] = tree[opened].leftIdx;
+            slots.push_back(tree[opened].leftIdx + 1);
+        }
+
+        int nodeIdx = m_nodes.size();
+        m_nodes.push_back(BVH4Node());
+
+        for (int c = 0; c < 4; ++c)
+        {
+            // not using a reference on m_nodes[nodeIdx] : the recursion below reallocates the pool
+            if (c >= (int) slots.size())
+            {
+                setChild(nodeIdx, c, glm::vec3(BVH4_FAR_BOUND), glm::vec3(BVH4_FAR_BOUND), BVH4_EMPTY_CHILD, 0);
+                continue;
+            }
+
+            Node &child = tree[slots[c]];
+            if (child.triCount != 0)
+            {
+                int first = m_triangles.size();
+                for (int i = 0; i < child.triCount; ++i)
+                {
+                    int triIdx = m_bvh->triIndices()[child.leftIdx + i];
+                    Triangle &tri = m_bvh->tri()[triIdx];
+                    float idxBits;
+                    memcpy(&idxBits, &triIdx, sizeof(float));
+                    m_triangles.push_back(HotTriangle {
+                        glm::vec4(tri.p0, idxBits),
+                        glm::vec4(tri.p1 - tri.p0, 0.0f),
+                        glm::vec4(tri.p2 - tri.p0, 0.0f)
+                        });
+                }
+                setChild(nodeIdx, c, child.aabb.aabbMin, child.aabb.aabbMax, ~first, child.triCount);
+            }
+            else
+            {
+                int childIdx = collapse(std::vector<int> {child.leftIdx, child.leftIdx + 1});
+                setChild(nodeIdx, c, child.aabb.aabbMin, child.aabb.aabbMax, childIdx, 0);
+            }
+        }
+        return nodeIdx;
+    }
+
+    void setChild(int nodeIdx, int c, glm::vec3 bbmin, glm::vec3 bbmax, int child, int triCount)
+    {
+        BVH4Node &node = m_nodes[nodeIdx];
+        node.minX[c] = bbmin.x;
+        node.minY[c] = bbmin.y;
+        node.minZ[c] = bbmin.z;
+        node.maxX[c] = bbmax.x;
+        node.maxY[c] = bbmax.y;
+        node.maxZ[c] = bbmax.z;
+        node.children[c] = child;
+        node.triCount[c] = triCount;
+    }
+};
+
+inline void intersectBinary(BVH *bvh, glm::vec3 origin, glm::vec3 dir, RayHit &hit, RayQueryStats &stats)
+{
+    /**
+     * Scalar traversal of the binary tree on the host (reference for the BVH4 comparisons)
+    */
+    Node *tree = bvh->getTree();
+    Triangle *triangles = bvh->tri();
+    GLuint *triIndices = bvh->triIndices();
+
+    int stack[128];
+    int stackSize = 0;
+    float tNear;
+
+    stats.queries++;
+    stats.nodesVisited++;
+    if (!hostIntersectRayAABB(origin, dir, tree[0].aabb.aabbMin, tree[0].aabb.aabbMax, &tNear)) return;
+    stack[stackSize++] = 0;
+
+    while (stackSize != 0)
+    {
+        Node &node = tree[stack[--stackSize]];
+        if (node.triCount != 0)
+        {
+            for (int k = 0; k < node.triCount; ++k)
+            {
+                GLuint idx = triIndices[node.leftIdx + k];
+                Triangle &tri = triangles[idx];
+                HotTriangle hot = {glm::vec4(tri.p0, 0.0f), glm::vec4(tri.p1 - tri.p0, 0.0f), glm::vec4(tri.p2 - tri.p0, 0.0f)};
+                stats.trianglesTested++;
+                if (hostIntersectSegmentTriangle(origin, dir, hot, &hit.hitInfo)) hit.triIdx = idx;
+            }
+            continue;
+        }
+        for (int c = 0; c < 2; ++c)
+        {
+            Node &child = tree[node.leftIdx + c];
+            stats.nodesVisited++;
+            if (hostIntersectRayAABB(origin, dir, child.aabb.aabbMin, child.aabb.aabbMax, &tNear) && tNear <= HOST_MAX_SCENE_BOUNDS)
+            {
+                stack[stackSize++] = node.leftIdx + c;
+            }
+        }
+    }
+}
+
+inline RayQueryStats queryClothRays(
+    BVH4 *bvh4,
+    const glm::vec3 *positions,
+    const glm::vec3 *normals,
+    int nbVertices,
+    RayHit *hits,
+    int nbThreads = 1
+    )
+{
+    /**
+     * Host query kernel : for each cloth vertex, casts the segments along -n and n (as CollisionSolver::solve does)
+     * and keeps the closest hit. Vertices are split in contiguous chunks among the threads.
+    */
+    std::vector<RayQueryStats> stats(nbThreads, RayQueryStats {0, 0, 0});
+    std::vector<std::thread> workers;
+
+    auto work = [&](int t)
+    {
+        int begin = (long long) nbVertices * t / nbThreads;
+        int end = (long long) nbVertices * (t+1) / nbThreads;
+        for (int v = begin; v < end; ++v)
+        {
+            RayHit hit = {-1, glm::vec4(10e30f)};
+            bvh4->intersect(positions[v], -normals[v], hit, stats[t]);
+            bvh4->intersect(positions[v], normals[v], hit, stats[t]);
+            hits[v] = hit;
+        }
+    };
+
+    for (int t = 1; t < nbThreads; ++t) workers.push_back(std::thread(work, t));
+    work(0);
+    for (auto &worker : workers) worker.join();
+
+    RayQueryStats total = {0, 0, 0};
+    for (auto &s : stats)
+    {
+        total.queries += s.queries;
+        total.nodesVisited += s.nodesVisited;
+        total.trianglesTested += s.trianglesTested;
+    }
+    return total;
+}
+
+#endif
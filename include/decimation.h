@@ -0,0 +1,394 @@
+#ifndef DECIMATION_H
+#define DECIMATION_H
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <cstdio>
+#include "glm/glm.hpp"
+
+#define PROXY_TOLERANCE 0.5f // default error bound of the collision proxies, in cloth thicknesses
+#define PROXY_BOUNDARY_WEIGHT 100.0f // weight of the planes keeping the open borders in place
+#define PROXY_MIN_NORMAL_COS 0.2f // collapses turning a triangle further than this are rejected (fold-overs)
+
+struct Quadric
+{
+    /**
+     * Sum of the squared distances to a set of planes (n, d) : Q(p) = p^T A p + 2 b.p + c, with A = sum n n^T,
+     * b = sum d n and c = sum d^2 (upper triangle of the symmetric 4x4 matrix, in double precision)
+    */
+    double a[10];
+
+    Quadric() {std::fill(a, a+10, 0.0);}
+
+    static Quadric plane(glm::dvec3 n, double d, double weight)
+    {
+        Quadric q;
+        q.a[0] = weight*n.x*n.x; q.a[1] = weight*n.x*n.y; q.a[2] = weight*n.x*n.z; q.a[3] = weight*n.x*d;
+        q.a[4] = weight*n.y*n.y; q.a[5] = weight*n.y*n.z; q.a[6] = weight*n.y*d;
+        q.a[7] = weight*n.z*n.z; q.a[8] = weight*n.z*d;
+        q.a[9] = weight*d*d;
+        return q;
+    }
+
+    Quadric &operator+=(const Quadric &q)
+    {
+        for (int k = 0; k < 10; ++k) a[k] += q.a[k];
+        return *this;
+    }
+
+    double evaluate(glm::dvec3 p) const
+    {
+        return a[0]*p.x*p.x + 2.0*a[1]*p.x*p.y + 2.0*a[2]*p.x*p.z + 2.0*a[3]*p.x
+             + a[4]*p.y*p.y + 2.0*a[5]*p.y*p.z + 2.0*a[6]*p.y
+             + a[7]*p.z*p.z + 2.0*a[8]*p.z
+             + a[9];
+    }
+
+    bool minimum(glm::dvec3 &p) const
+    {
+        // A p = -b, rejected when A is close to singular (flat or linear neighbourhoods)
+        glm::dmat3 A(a[0], a[1], a[2], a[1], a[4], a[5], a[2], a[5], a[7]);
+        double det = glm::determinant(A);
+        if (std::abs(det) < 1e-12*(a[0] + a[4] + a[7])*(a[0] + a[4] + a[7])*(a[0] + a[4] + a[7])) return false;
+        p = glm::inverse(A)*glm::dvec3(-a[3], -a[6], -a[8]);
+        return true;
+    }
+};
+
+struct CollisionProxy
+{
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals; // area weighted
+    std::vector<unsigned int> indices;
+    float error; // bound on the distance of the proxy's vertices to the planes of the triangles they replace
+    double buildTime; // in s
+};
+
+class Decimation
+{
+    /**
+     * Quadric error edge collapse (Garland & Heckbert) : the vertices are welded by position, every edge gets the cost
+     * of collapsing it to the point minimizing the sum of the squared distances to the planes of both vertices'
+     * triangles, and the cheapest edges are collapsed first (lazy priority queue : the entries of the edges of a
+     * modified vertex are outdated by its stamp). Open borders are kept by heavy planes orthogonal to them,
+     * non manifold collapses and fold-overs are rejected.
+     * It stops at the target triangle count, or when the next collapse would move the surface by more than the
+     * tolerance : sqrt(cost) bounds the distance to every accumulated plane.
+    */
+    public:
+    Decimation(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &indices)
+    {
+        weld(vertices, indices);
+    }
+
+    CollisionProxy run(int targetTriangles, float tolerance)
+    {
+        auto start = std::chrono::steady_clock::now();
+        computeQuadrics();
+
+        std::vector<glm::ivec2> edges = uniqueEdges();
+        for (const glm::ivec2 &e : edges) pushCollapse(e.x, e.y);
+
+        double maxCost = (double) tolerance*tolerance;
+        double appliedCost = 0.0;
+        while (m_nbActive > targetTriangles && !m_heap.empty())
+        {
+            Collapse c = m_heap.top();
+            m_heap.pop();
+            if (m_removed[c.a] || m_removed[c.b] || c.stampA != m_stamps[c.a] || c.stampB != m_stamps[c.b]) continue;
+            if (c.cost > maxCost) break; // every edge has an up to date entry : the remaining ones cost more
+            if (!isValid(c)) continue;
+
+            collapse(c);
+            appliedCost = std::max(appliedCost, c.cost);
+        }
+
+        CollisionProxy proxy = compact();
+        proxy.error = (float) std::sqrt(appliedCost);
+        proxy.buildTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return proxy;
+    }
+
+    int getNbWeldedVertices() {return m_positions.size();};
+
+    private:
+    struct Collapse
+    {
+        double cost;
+        int a; // kept vertex, moved to target
+        int b; // removed vertex
+        int stampA;
+        int stampB;
+        glm::dvec3 target;
+
+        bool operator<(const Collapse &other) const {return cost > other.cost;}; // cheapest on top
+    };
+
+    void weld(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &indices)
+    {
+        /**
+         * Vertices with the same position are merged (files split them along texture / normal seams), then
+         * degenerate triangles are dropped
+        */
+        std::vector<int> order(vertices.size());
+        std::iota(order.begin(), order.end(), 0);
+        auto lexicographic = [&vertices](int i, int j) {
+            const glm::vec3 &p = vertices[i], &q = vertices[j];
+            return p.x < q.x || (p.x == q.x && (p.y < q.y || (p.y == q.y && p.z < q.z)));
+        };
+        std::sort(order.begin(), order.end(), lexicographic);
+
+        std::vector<int> welded(vertices.size());
+        for (int k = 0; k < (int) order.size(); ++k)
+        {
+            if (k == 0 || vertices[order[k]] != vertices[order[k-1]]) m_positions.push_back(glm::dvec3(vertices[order[k]]));
+            welded[order[k]] = m_positions.size()-1;
+        }
+
+        for (int idx = 0; idx+2 < (int) indices.size(); idx += 3)
+        {
+            glm::ivec3 f(welded[indices[idx]], welded[indices[idx+1]], welded[indices[idx+2]]);
+            if (f.x == f.y || f.y == f.z || f.z == f.x) continue;
+            m_faces.push_back(f);
+        }
+        m_nbActive = m_faces.size();
+        m_faceRemoved.assign(m_faces.size(), false);
+
+        m_vertexFaces.assign(m_positions.size(), std::vector<int>());
+        for (int f = 0; f < (int) m_faces.size(); ++f)
+            for (int k = 0; k < 3; ++k) m_vertexFaces[m_faces[f][k]].push_back(f);
+
+        m_removed.assign(m_positions.size(), false);
+        m_stamps.assign(m_positions.size(), 0);
+    }
+
+    glm::dvec3 faceNormal(const glm::ivec3 &f, double &area2)
+    {
+        glm::dvec3 n = glm::cross(m_positions[f.y] - m_positions[f.x], m_positions[f.z] - m_positions[f.x]);
+        area2 = glm::length(n);
+        return area2 > 0.0 ? n/area2 : n;
+    }
+
+    void computeQuadrics()
+    {
+        m_quadrics.assign(m_positions.size(), Quadric());
+        for (const glm::ivec3 &f : m_faces)
+        {
+            double area2;
+            glm::dvec3 n = faceNormal(f, area2);
+            if (area2 == 0.0) continue;
+            Quadric q = Quadric::plane(n, -glm::dot(n, m_positions[f.x]), 1.0);
+            for (int k = 0; k < 3; ++k) m_quadrics[f[k]] += q;
+        }
+
+        // open borders : plane containing the border edge, orthogonal to its triangle
+        std::vector<std::pair<unsigned long long, int>> halfEdges;
+        for (int f = 0; f < (int) m_faces.size(); ++f)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned long long u = std::min(m_faces[f][k], m_faces[f][(k+1)%3]);
+                unsigned long long v = std::max(m_faces[f][k], m_faces[f][(k+1)%3]);
+                halfEdges.push_back(std::make_pair((u << 32) | v, f));
+            }
+        }
+        std::sort(halfEdges.begin(), halfEdges.end());
+        for (int k = 0; k < (int) halfEdges.size(); ++k)
+        {
+            bool isShared = (k > 0 && halfEdges[k-1].first == halfEdges[k].first) ||
+                (k+1 < (int) halfEdges.size() && halfEdges[k+1].first == halfEdges[k].first);
+            if (isShared) continue;
+
+            int u = (int) (halfEdges[k].first >> 32);
+            int v = (int) (halfEdges[k].first & 0xffffffffull);
+            double area2;
+            glm::dvec3 n = faceNormal(m_faces[halfEdges[k].second], area2);
+            glm::dvec3 e = m_positions[v] - m_positions[u];
+            glm::dvec3 borderNormal = glm::cross(e, n);
+            if (glm::length(borderNormal) == 0.0) continue;
+            borderNormal = glm::normalize(borderNormal);
+            Quadric q = Quadric::plane(borderNormal, -glm::dot(borderNormal, m_positions[u]), PROXY_BOUNDARY_WEIGHT);
+            m_quadrics[u] += q;
+            m_quadrics[v] += q;
+        }
+    }
+
+    std::vector<glm::ivec2> uniqueEdges()
+    {
+        std::vector<glm::ivec2> edges;
+        for (const glm::ivec3 &f : m_faces)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                int u = f[k], v = f[(k+1)%3];
+                edges.push_back(glm::ivec2(std::min(u, v), std::max(u, v)));
+            }
+        }
+        std::sort(edges.begin(), edges.end(), [](const glm::ivec2 &e0, const glm::ivec2 &e1) {
+            return e0.x < e1.x || (e0.x == e1.x && e0.y < e1.y);
+        });
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        return edges;
+    }
+
+    void pushCollapse(int a, int b)
+    {
+        Quadric q = m_quadrics[a];
+        q += m_quadrics[b];
+
+        // optimal point, or the best of the endpoints and the midpoint when it is not unique
+        glm::dvec3 target;
+        if (!q.minimum(target))
+        {
+            glm::dvec3 candidates[3] = {m_positions[a], m_positions[b], 0.5*(m_positions[a] + m_positions[b])};
+            target = candidates[0];
+            for (int k = 1; k < 3; ++k) if (q.evaluate(candidates[k]) < q.evaluate(target)) target = candidates[k];
+        }
+        double cost = std::max(q.evaluate(target), 0.0);
+        m_heap.push(Collapse {cost, a, b, m_stamps[a], m_stamps[b], target});
+    }
+
+    void neighbours(int v, std::vector<int> &ring)
+    {
+        ring.clear();
+        for (int f : m_vertexFaces[v])
+        {
+            if (m_faceRemoved[f]) continue;
+            for (int k = 0; k < 3; ++k) if (m_faces[f][k] != v) ring.push_back(m_faces[f][k]);
+        }
+        std::sort(ring.begin(), ring.end());
+        ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+    }
+
+    bool isValid(const Collapse &c)
+    {
+        // link condition : the only common neighbours of a and b are the opposite vertices of the edge's triangles
+        neighbours(c.a, m_ringA);
+        neighbours(c.b, m_ringB);
+        int nbCommon = 0;
+        for (int v : m_ringA) nbCommon += std::binary_search(m_ringB.begin(), m_ringB.end(), v);
+
+        int nbEdgeFaces = 0;
+        for (int f : m_vertexFaces[c.a])
+        {
+            if (m_faceRemoved[f]) continue;
+            const glm::ivec3 &face = m_faces[f];
+            nbEdgeFaces += (face.x == c.b || face.y == c.b || face.z == c.b);
+        }
+        if (nbEdgeFaces == 0 || nbCommon != nbEdgeFaces) return false;
+
+        // no triangle around a or b may flip or degenerate once its vertex is moved to the target
+        int ends[2] = {c.a, c.b};
+        for (int v : ends)
+        {
+            for (int f : m_vertexFaces[v])
+            {
+                if (m_faceRemoved[f]) continue;
+                glm::ivec3 face = m_faces[f];
+                if ((face.x == c.a || face.y == c.a || face.z == c.a) && (face.x == c.b || face.y == c.b || face.z == c.b)) continue;
+
+                double area2, movedArea2;
+                glm::dvec3 n = faceNormal(face, area2);
+                glm::dvec3 saved = m_positions[v];
+                m_positions[v] = c.target;
+                glm::dvec3 moved = faceNormal(face, movedArea2);
+                m_positions[v] = saved;
+                if (movedArea2 == 0.0 || glm::dot(n, moved) < PROXY_MIN_NORMAL_COS) return false;
+            }
+        }
+        return true;
+    }
+
+    void collapse(const Collapse &c)
+    {
+        m_positions[c.a] = c.target;
+        m_quadrics[c.a] += m_quadrics[c.b];
+        m_removed[c.b] = true;
+        m_stamps[c.a]++;
+
+        for (int f : m_vertexFaces[c.b])
+        {
+            if (m_faceRemoved[f]) continue;
+            glm::ivec3 &face = m_faces[f];
+            if (face.x == c.a || face.y == c.a || face.z == c.a)
+            {
+                m_faceRemoved[f] = true;
+                m_nbActive--;
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) if (face[k] == c.b) face[k] = c.a;
+            m_vertexFaces[c.a].push_back(f);
+        }
+        m_vertexFaces[c.b].clear();
+
+        std::vector<int> &faces = m_vertexFaces[c.a];
+        faces.erase(std::remove_if(faces.begin(), faces.end(), [this](int f) {return m_faceRemoved[f];}), faces.end());
+
+        neighbours(c.a, m_ringA);
+        for (int v : m_ringA) pushCollapse(c.a, v);
+    }
+
+    CollisionProxy compact()
+    {
+        CollisionProxy proxy;
+        std::vector<int> remap(m_positions.size(), -1);
+        for (int f = 0; f < (int) m_faces.size(); ++f)
+        {
+            if (m_faceRemoved[f]) continue;
+            for (int k = 0; k < 3; ++k)
+            {
+                int v = m_faces[f][k];
+                if (remap[v] < 0)
+                {
+                    remap[v] = proxy.vertices.size();
+                    proxy.vertices.push_back(glm::vec3(m_positions[v]));
+                }
+                proxy.indices.push_back(remap[v]);
+            }
+        }
+
+        proxy.normals.assign(proxy.vertices.size(), glm::vec3(0.0f));
+        for (int idx = 0; idx < (int) proxy.indices.size(); idx += 3)
+        {
+            const std::vector<glm::vec3> &p = proxy.vertices;
+            unsigned int i0 = proxy.indices[idx], i1 = proxy.indices[idx+1], i2 = proxy.indices[idx+2];
+            glm::vec3 n = glm::cross(p[i1] - p[i0], p[i2] - p[i0]);
+            proxy.normals[i0] += n;
+            proxy.normals[i1] += n;
+            proxy.normals[i2] += n;
+        }
+        for (glm::vec3 &n : proxy.normals) n = glm::length(n) > 0.0f ? glm::normalize(n) : glm::vec3(0.0f, 1.0f, 0.0f);
+        return proxy;
+    }
+
+    std::vector<glm::dvec3> m_positions;
+    std::vector<glm::ivec3> m_faces;
+    std::vector<bool> m_faceRemoved;
+    std::vector<std::vector<int>> m_vertexFaces;
+    std::vector<Quadric> m_quadrics;
+    std::vector<bool> m_removed;
+    std::vector<int> m_stamps;
+    std::priority_queue<Collapse> m_heap;
+    std::vector<int> m_ringA;
+    std::vector<int> m_ringB;
+    int m_nbActive;
+};
+
+inline CollisionProxy decimateMesh(const std::vector<glm::vec3> &vertices, const std::vector<unsigned int> &indices, int targetTriangles, 
+    float tolerance, bool isVerbose = false)
+{
+    /**
+     * Collision proxy of a mesh : as few triangles as possible (down to targetTriangles) without moving its surface
+     * by more than tolerance (the simulation reports it in the collision stats, the tools ask for a verbose build)
+    */
+    Decimation decimation(vertices, indices);
+    CollisionProxy proxy = decimation.run(targetTriangles, tolerance);
+    if (isVerbose) printf("Collision proxy : %i -> %i triangles (error %.5f <= %.5f) in %f s\n", (int) indices.size()/3,
+        (int) proxy.indices.size()/3, proxy.error, tolerance, proxy.buildTime);
+    return proxy;
+}
+
+#endif
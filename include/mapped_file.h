@@ -0,0 +1,64 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <algorithm>
+
+class MappedFile
+{
+    /**
+     * Read-only mapping of a whole file : its pages are read on first access and belong to the page cache (they can
+     * be dropped under memory pressure), nothing is copied to the heap
+    */
+    public:
+    MappedFile(const std::string &path) : m_data(nullptr), m_size(0)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED)
+            {
+                m_data = (const char *) ptr;
+                m_size = st.st_size;
+                madvise(ptr, m_size, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile()
+    {
+        if (m_data) munmap((void *) m_data, m_size);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    void prefetch(size_t offset, size_t size) const
+    {
+        /**
+         * Asks the kernel to read a range ahead (asynchronous) : e.g. the next frames of a cache being played
+        */
+        if (!m_data || offset >= m_size) return;
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t begin = offset - offset % page;
+        madvise((void *) (m_data + begin), std::min(offset + size, m_size) - begin, MADV_WILLNEED);
+    }
+
+    bool isOpen() const {return m_data != nullptr;};
+    const char *data() const {return m_data;};
+    size_t size() const {return m_size;};
+
+    private:
+    const char *m_data;
+    size_t m_size;
+};
+
+#endif
@@ -0,0 +1,373 @@
+#ifndef MESH_SEQUENCE_H
+#define MESH_SEQUENCE_H
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include "glm/glm.hpp"
+
+// Cloth mesh sequences for debugging and the tools without point cache support : one file per frame,
+// <prefix>_<frame>.ply / .obj, positions, normals and the triangles of the cloth.
+// PLY : binary little endian, x y z nx ny nz per vertex. OBJ : text, each vertex as a "v" and a "vn" line (same index),
+//       floats in their shortest form that reads back to the same value (see formatFloat).
+// The triangles never change : their section (and the PLY header) is built once and written as is with every frame.
+
+enum MeshSequenceFormat
+{
+    MESH_SEQUENCE_PLY,
+    MESH_SEQUENCE_OBJ
+};
+
+const int FLOAT_TEXT_MAX = 16; // "-1.23456789e-38" and the separator
+
+inline int formatInt(uint32_t value, char *out)
+{
+    char digits[10];
+    int n = 0;
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    for (int k = 0; k < n; ++k) out[k] = digits[n-1-k];
+    return n;
+}
+
+const double POW10[23] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+    1e18, 1e19, 1e20, 1e21, 1e22};
+
+inline int roundDigits(double v, int e10, int nbDigits, double lo, double hi, bool isEven, uint64_t &digits, int &scale)
+{
+    /**
+     * Nearest candidate with nbDigits significant digits (v ~ digits*10^-scale) : 1 when it reads back as v (inside the
+     * rounding interval [lo, hi], its bounds only when they round to v : even mantissa and candidate exact), 0 when it
+     * does not, -1 when 10^scale is not exact in double
+    */
+    scale = nbDigits - 1 - e10;
+    if (scale > 22 || scale < -22) return -1;
+    double scaled = scale >= 0 ? v*POW10[scale] : v/POW10[-scale];
+    digits = (uint64_t) (scaled + 0.5);
+    double candidate = scale >= 0 ? digits/POW10[scale] : digits*POW10[-scale];
+    if (lo < candidate && candidate < hi) return 1;
+    if (!isEven || (candidate != lo && candidate != hi)) return 0;
+    return (scale >= 0 ? std::fma(candidate, POW10[scale], -(double) digits) : std::fma((double) digits, POW10[-scale], -candidate)) == 0.0;
+}
+
+inline int formatFloat(float value, char *out)
+{
+    /**
+     * Shortest decimal string that strtof reads back as value (the nearest one among those of that length), written to
+     * out without terminator, returns its length. The rounding interval of value (half way to its neighbours) is exact in
+     * double, and so are the candidates' bounds checks as long as 10^scale is (|scale| <= 22) : the number of digits is
+     * found by bisection over 1..9 (a candidate of p digits inside the interval implies one of p+1 digits, except below a
+     * power of two where the interval is not symmetric : scanned in order). Out of the exact range (below ~1e-13, above
+     * ~1e22) the candidates go through snprintf / strtof.
+    */
+    char *p = out;
+    if (std::signbit(value))
+    {
+        *p++ = '-';
+        value = -value;
+    }
+    if (value == 0.0f)
+    {
+        *p++ = '0';
+        return p - out;
+    }
+    if (!std::isfinite(value))
+    {
+        memcpy(p, value != value ? "nan" : "inf", 3);
+        return p + 3 - out;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    int exponent2 = bits >> 23; // (biased)
+    uint32_t mantissa = bits & 0x7fffff;
+    double v = value;
+    uint64_t ulpBits = (uint64_t) (std::max(exponent2, 1) - 150 + 1023) << 52; // 2^(e-23) : spacing of the floats around v
+    double ulp;
+    memcpy(&ulp, &ulpBits, sizeof(double));
+    double lo = v - ((mantissa == 0 && exponent2 > 1) ? 0.25 : 0.5)*ulp;
+    double hi = v + 0.5*ulp;
+    bool isEven = (mantissa & 1) == 0;
+    int e10 = exponent2 > 0 ? ((exponent2 - 127)*78913) >> 18 : (int) std::floor(std::log10(v)); // floor(log10(2^e))
+    if (e10 + 1 <= 22 && e10 + 1 >= -22 && v >= (e10 + 1 >= 0 ? POW10[e10 + 1] : 1.0/POW10[-e10 - 1])) e10++; // (v in [2^e, 2^e+1))
+
+    uint64_t digits = 0;
+    int scale = 0;
+    int isFound = 0;
+    if (mantissa == 0)
+    {
+        for (int nbDigits = 1; nbDigits <= 9 && isFound == 0; ++nbDigits) isFound = roundDigits(v, e10, nbDigits, lo, hi, isEven, digits, scale);
+    }
+    else
+    {
+        int low = 1, high = 9, nbFound = 0;
+        uint64_t highDigits = 0;
+        int highScale = 0;
+        while (low < high && isFound >= 0)
+        {
+            int middle = (low + high)/2;
+            isFound = roundDigits(v, e10, middle, lo, hi, isEven, digits, scale);
+            if (isFound == 1)
+            {
+                high = nbFound = middle;
+                highDigits = digits;
+                highScale = scale;
+            }
+            else low = middle + 1;
+        }
+        if (isFound >= 0 && nbFound == low)
+        {
+            digits = highDigits;
+            scale = highScale;
+            isFound = 1;
+        }
+        else if (isFound >= 0) isFound = roundDigits(v, e10, low, lo, hi, isEven, digits, scale);
+    }
+    if (isFound != 1)
+    {
+        char text[32];
+        for (int nbDigits = 1; nbDigits <= 9; ++nbDigits)
+        {
+            snprintf(text, sizeof(text), "%.*e", nbDigits-1, v);
+            if (strtof(text, nullptr) == value || nbDigits == 9) break;
+        }
+        // (d.ddde[+-]x : back to digits and scale)
+        char *exponent = strchr(text, 'e');
+        digits = 0;
+        int nbDigits = 0;
+        for (char *c = text; c < exponent; ++c)
+        {
+            if (*c == '.') continue;
+            digits = 10*digits + (*c - '0');
+            nbDigits++;
+        }
+        scale = nbDigits - 1 - atoi(exponent + 1);
+    }
+    while (digits % 10 == 0 && digits > 0)
+    {
+        digits /= 10;
+        scale--;
+    }
+    char text[20];
+    int n = formatInt(digits, text);
+    int point = n - scale; // digits before the decimal point
+    if (point > 0 && point <= 9)
+    {
+        int nbInteger = std::min(point, n);
+        memcpy(p, text, nbInteger);
+        p += nbInteger;
+        for (int k = n; k < point; ++k) *p++ = '0';
+        if (point < n)
+        {
+            *p++ = '.';
+            memcpy(p, text + point, n - point);
+            p += n - point;
+        }
+    }
+    else if (point <= 0 && point > -4)
+    {
+        *p++ = '0';
+        *p++ = '.';
+        for (int k = point; k < 0; ++k) *p++ = '0';
+        memcpy(p, text, n);
+        p += n;
+    }
+    else
+    {
+        *p++ = text[0];
+        if (n > 1)
+        {
+            *p++ = '.';
+            memcpy(p, text + 1, n - 1);
+            p += n - 1;
+        }
+        *p++ = 'e';
+        int exponent = point - 1;
+        if (exponent < 0)
+        {
+            *p++ = '-';
+            exponent = -exponent;
+        }
+        p += formatInt(exponent, p);
+    }
+    return p - out;
+}
+
+class MeshSequenceWriter
+{
+    public:
+    MeshSequenceWriter(const std::string &prefix, MeshSequenceFormat format, int nbVertices, const std::vector<unsigned int> &indices,
+        int nbThreads = 0)
+    : m_prefix(prefix),
+    m_format(format),
+    m_nbVertices(nbVertices),
+    m_nbThreads(nbThreads > 0 ? nbThreads : std::max(1u, std::thread::hardware_concurrency())),
+    m_nbFrames(0),
+    m_bytes(0),
+    m_formatTime(0.0),
+    m_writeTime(0.0)
+    {
+        /**
+         * indices : the cloth's triangles (Mesh::getIndices), nbThreads : threads formatting an OBJ frame (0 : one per core)
+        */
+        int nbTriangles = indices.size()/3;
+        if (format == MESH_SEQUENCE_PLY)
+        {
+            char header[512];
+            int n = snprintf(header, sizeof(header), "ply\nformat binary_little_endian 1.0\nelement vertex %i\n"
+                "property float x\nproperty float y\nproperty float z\nproperty float nx\nproperty float ny\nproperty float nz\n"
+                "element face %i\nproperty list uchar int vertex_indices\nend_header\n", nbVertices, nbTriangles);
+            m_header.assign(header, header + n);
+
+            m_faces.resize(13*nbTriangles);
+            for (int t = 0; t < nbTriangles; ++t)
+            {
+                m_faces[13*t] = 3;
+                for (int k = 0; k < 3; ++k)
+                {
+                    int32_t index = indices[3*t + k];
+                    memcpy(&m_faces[13*t + 1 + 4*k], &index, sizeof(int32_t));
+                }
+            }
+        }
+        else
+        {
+            char header[128];
+            int n = snprintf(header, sizeof(header), "# cloth : %i vertices, %i triangles\n", nbVertices, nbTriangles);
+            m_header.assign(header, header + n);
+
+            m_faces.resize(nbTriangles*(2 + 3*(2*10 + 3)));
+            char *p = m_faces.data();
+            for (int t = 0; t < nbTriangles; ++t)
+            {
+                *p++ = 'f';
+                for (int k = 0; k < 3; ++k)
+                {
+                    *p++ = ' ';
+                    int n = formatInt(indices[3*t + k] + 1, p); // (OBJ indices start at 1)
+                    memcpy(p + n, "//", 2);
+                    memcpy(p + n + 2, p, n);
+                    p += 2*n + 2;
+                }
+                *p++ = '\n';
+            }
+            m_faces.resize(p - m_faces.data());
+            m_chunks.resize(m_nbThreads);
+            m_chunkSizes.resize(m_nbThreads);
+        }
+    }
+
+    int nbFrames() {return m_nbFrames;};
+    size_t bytes() {return m_bytes;};
+    double formatTime() {return m_formatTime;}; // in s
+    double writeTime() {return m_writeTime;}; // in s
+    std::string path(int frame)
+    {
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), "_%05i.%s", frame, m_format == MESH_SEQUENCE_PLY ? "ply" : "obj");
+        return m_prefix + suffix;
+    }
+
+    bool writeFrame(int frame, const glm::vec3 *positions, const glm::vec3 *normals)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (m_format == MESH_SEQUENCE_PLY)
+        {
+            m_vertices.resize(6*m_nbVertices);
+            for (int k = 0; k < m_nbVertices; ++k)
+            {
+                memcpy(&m_vertices[6*k], &positions[k], sizeof(glm::vec3));
+                memcpy(&m_vertices[6*k + 3], &normals[k], sizeof(glm::vec3));
+            }
+        }
+        else
+        {
+            std::vector<std::thread> threads;
+            for (int t = 1; t < m_nbThreads; ++t) threads.push_back(std::thread(&MeshSequenceWriter::formatChunk, this, t, positions, normals));
+            formatChunk(0, positions, normals);
+            for (std::thread &thread : threads) thread.join();
+        }
+        auto formatted = std::chrono::steady_clock::now();
+
+        FILE *file = fopen(path(frame).c_str(), "wb");
+        if (!file) return false;
+        size_t size = m_header.size() + m_faces.size();
+        bool isValid = fwrite(m_header.data(), 1, m_header.size(), file) == m_header.size();
+        if (m_format == MESH_SEQUENCE_PLY)
+        {
+            isValid = isValid && fwrite(m_vertices.data(), sizeof(float), m_vertices.size(), file) == m_vertices.size();
+            size += sizeof(float)*m_vertices.size();
+        }
+        else
+        {
+            for (int t = 0; t < m_nbThreads && isValid; ++t)
+            {
+                isValid = fwrite(m_chunks[t].data(), 1, m_chunkSizes[t], file) == m_chunkSizes[t];
+                size += m_chunkSizes[t];
+            }
+        }
+        isValid = isValid && fwrite(m_faces.data(), 1, m_faces.size(), file) == m_faces.size();
+        isValid = (fclose(file) == 0) && isValid;
+
+        m_formatTime += std::chrono::duration<double>(formatted - start).count();
+        m_writeTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - formatted).count();
+        if (!isValid) return false;
+        m_nbFrames++;
+        m_bytes += size;
+        return true;
+    }
+
+    private:
+    std::string m_prefix;
+    MeshSequenceFormat m_format;
+    int m_nbVertices;
+    int m_nbThreads;
+    std::vector<char> m_header;
+    std::vector<char> m_faces; // written with every frame
+    std::vector<float> m_vertices; // interleaved frame (PLY)
+    std::vector<std::vector<char>> m_chunks; // text of the vertices, one range per thread (OBJ)
+    std::vector<size_t> m_chunkSizes;
+
+    int m_nbFrames;
+    size_t m_bytes;
+    double m_formatTime;
+    double m_writeTime;
+
+    void formatChunk(int t, const glm::vec3 *positions, const glm::vec3 *normals)
+    {
+        int begin = (long long) m_nbVertices*t/m_nbThreads;
+        int end = (long long) m_nbVertices*(t+1)/m_nbThreads;
+        std::vector<char> &chunk = m_chunks[t];
+        chunk.resize((size_t) (end - begin)*2*(3 + 3*FLOAT_TEXT_MAX));
+        char *p = chunk.data();
+        for (int k = begin; k < end; ++k)
+        {
+            *p++ = 'v';
+            for (int c = 0; c < 3; ++c)
+            {
+                *p++ = ' ';
+                p += formatFloat(positions[k][c], p);
+            }
+            memcpy(p, "\nvn", 3);
+            p += 3;
+            for (int c = 0; c < 3; ++c)
+            {
+                *p++ = ' ';
+                p += formatFloat(normals[k][c], p);
+            }
+            *p++ = '\n';
+        }
+        m_chunkSizes[t] = p - chunk.data();
+    }
+};
+
+#endif
@@ -0,0 +1,383 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include "glm/glm.hpp"
+#include "mapped_file.h"
+
+#define OBJ_NO_INDEX -1
+#define OBJ_RELATIVE_BASE (1 << 30) // relative indices of a chunk are stored shifted below OBJ_NO_INDEX by this much
+
+template <typename F>
+void parallelRanges(int nbThreads, size_t n, F f)
+{
+    /**
+     * f(begin, end, thread) on nbThreads contiguous ranges of [0, n)
+    */
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nbThreads; ++t)
+    {
+        size_t begin = n*t/nbThreads, end = n*(t+1)/nbThreads;
+        threads.push_back(std::thread(f, begin, end, t));
+    }
+    for (std::thread &thread : threads) thread.join();
+}
+
+inline bool isBlank(char c) {return c == ' ' || c == '\t' || c == '\r';}
+
+inline const char *skipBlanks(const char *p, const char *end)
+{
+    while (p < end && isBlank(*p)) p++;
+    return p;
+}
+
+inline bool parseInt(const char *&p, const char *end, int &value)
+{
+    bool isNegative = (p < end && *p == '-');
+    if (p < end && (*p == '-' || *p == '+')) p++;
+    if (p == end || *p < '0' || *p > '9') return false;
+    long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') v = 10*v + (*p++ - '0');
+    value = (int) (isNegative ? -v : v);
+    return true;
+}
+
+inline bool parseFloat(const char *&p, const char *end, float &value)
+{
+    /**
+     * Decimal float without locale nor allocation : digits accumulated in an integer mantissa, then scaled once by a
+     * power of 10 (exact up to 19 significant digits, then within an ulp of the correctly rounded value)
+    */
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    bool isNegative = (p < end && *p == '-');
+    if (p < end && (*p == '-' || *p == '+')) p++;
+
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int nbDigits = 0;
+    bool hasDigits = false;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        if (nbDigits < 19) {mantissa = 10*mantissa + (*p - '0'); nbDigits += (mantissa > 0);}
+        else exponent++;
+        p++;
+        hasDigits = true;
+    }
+    if (p < end && *p == '.')
+    {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9')
+        {
+            if (nbDigits < 19) {mantissa = 10*mantissa + (*p - '0'); nbDigits += (mantissa > 0); exponent--;}
+            p++;
+            hasDigits = true;
+        }
+    }
+    if (!hasDigits) return false;
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p+1;
+        int e;
+        if (parseInt(q, end, e)) {exponent += e; p = q;}
+    }
+
+    double v = (double) mantissa;
+    while (exponent > 22) {v *= 1e22; exponent -= 22;}
+    while (exponent < -22) {v /= 1e22; exponent += 22;}
+    v = exponent >= 0 ? v*powers[exponent] : v/powers[-exponent];
+    value = (float) (isNegative ? -v : v);
+    return true;
+}
+
+struct OBJCorner
+{
+    // 0-based indices of the corner's position, uv and normal (OBJ_NO_INDEX : none)
+    int v;
+    int vt;
+    int vn;
+};
+
+struct OBJMesh
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals; // empty if the file has none
+    std::vector<glm::vec2> uvs; // empty if the file has none
+    std::vector<unsigned int> indices;
+    int nbCorners; // vertices before welding (one per triangle corner)
+};
+
+class OBJParser
+{
+    /**
+     * Multithreaded OBJ parser : the mapped file is split in chunks on line boundaries, each thread parses its chunk
+     * (v, vt, vn and polygon faces split in fans, other statements ignored), then the chunks' arrays are concatenated
+     * and their relative (negative) indices resolved.
+     * Corners with the same position / uv / normal values are welded into a single vertex through a concurrent hash
+     * table (open addressing, lock-free insertion keeping the first corner of each vertex) : the vertices are numbered
+     * in the order of their first corner whatever the thread count.
+    */
+    public:
+    OBJParser(int nbThreads = 0) : m_nbThreads(nbThreads > 0 ? nbThreads : std::max(1, (int) std::thread::hardware_concurrency())) {}
+
+    bool parse(const std::string &path, OBJMesh &mesh)
+    {
+        MappedFile file(path);
+        if (!file.isOpen()) return false;
+
+        // chunks on line boundaries
+        std::vector<const char *> bounds(m_nbThreads+1);
+        const char *end = file.data() + file.size();
+        bounds[0] = file.data();
+        bounds[m_nbThreads] = end;
+        for (int t = 1; t < m_nbThreads; ++t)
+        {
+            const char *p = std::max(file.data() + file.size()*t/m_nbThreads, bounds[t-1]);
+            while (p < end && *p != '\n') p++;
+            bounds[t] = p < end ? p+1 : end;
+        }
+
+        std::vector<Chunk> chunks(m_nbThreads);
+        std::vector<char> isValid(m_nbThreads, 1);
+        parallelRanges(m_nbThreads, m_nbThreads, [&](size_t, size_t, int t) {
+            isValid[t] = parseChunk(bounds[t], bounds[t+1], chunks[t]);
+        });
+        if (std::find(isValid.begin(), isValid.end(), 0) != isValid.end()) return false;
+
+        return merge(chunks) && weld(mesh);
+    }
+
+    private:
+    struct Chunk
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> uvs;
+        std::vector<OBJCorner> corners; // 3 per triangle, relative indices encoded by encodeIndex
+    };
+
+    static int encodeIndex(int raw, int localCount)
+    {
+        /**
+         * Positive indices are global (1-based). A negative one counts back from the elements read so far in the file : it
+         * is kept relative to the chunk's start (localCount + raw, negative when it points into an earlier chunk) and
+         * resolved by decodeIndex once the number of elements before the chunk is known
+        */
+        if (raw > 0) return raw-1;
+        if (raw < 0) return (int) std::max((long long) localCount + raw - OBJ_RELATIVE_BASE, (long long) INT_MIN);
+        return OBJ_NO_INDEX;
+    }
+
+    static int decodeIndex(int encoded, int chunkOffset)
+    {
+        // (a relative index pointing before the start of the file decodes below OBJ_NO_INDEX : invalid)
+        if (encoded >= OBJ_NO_INDEX) return encoded;
+        long long index = (long long) chunkOffset + encoded + OBJ_RELATIVE_BASE;
+        return index >= 0 ? (int) index : OBJ_NO_INDEX - 1;
+    }
+
+    bool parseChunk(const char *p, const char *end, Chunk &chunk)
+    {
+        std::vector<OBJCorner> polygon;
+        while (p < end)
+        {
+            p = skipBlanks(p, end);
+            const char *lineEnd = (const char *) memchr(p, '\n', end - p);
+            if (!lineEnd) lineEnd = end;
+
+            if (lineEnd - p > 2 && p[0] == 'v' && isBlank(p[1]))
+            {
+                glm::vec3 v;
+                const char *q = p+2;
+                for (int k = 0; k < 3; ++k) if (!parseFloat(q = skipBlanks(q, lineEnd), lineEnd, v[k])) return false;
+                chunk.positions.push_back(v);
+            }
+            else if (lineEnd - p > 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2]))
+            {
+                glm::vec3 n;
+                const char *q = p+3;
+                for (int k = 0; k < 3; ++k) if (!parseFloat(q = skipBlanks(q, lineEnd), lineEnd, n[k])) return false;
+                chunk.normals.push_back(n);
+            }
+            else if (lineEnd - p > 3 && p[0] == 'v' && p[1] == 't' && isBlank(p[2]))
+            {
+                glm::vec2 uv;
+                const char *q = p+3;
+                for (int k = 0; k < 2; ++k) if (!parseFloat(q = skipBlanks(q, lineEnd), lineEnd, uv[k])) return false;
+                chunk.uvs.push_back(uv);
+            }
+            else if (lineEnd - p > 2 && p[0] == 'f' && isBlank(p[1]))
+            {
+                polygon.clear();
+                const char *q = skipBlanks(p+2, lineEnd);
+                while (q < lineEnd && *q != '#')
+                {
+                    int raw[3] = {0, 0, 0};
+                    if (!parseInt(q, lineEnd, raw[0])) return false;
+                    for (int k = 1; k < 3 && q < lineEnd && *q == '/'; ++k)
+                    {
+                        q++;
+                        if (q < lineEnd && *q != '/' && !isBlank(*q) && !parseInt(q, lineEnd, raw[k])) return false;
+                    }
+                    polygon.push_back(OBJCorner {encodeIndex(raw[0], chunk.positions.size()), encodeIndex(raw[1], chunk.uvs.size()),
+                        encodeIndex(raw[2], chunk.normals.size())});
+                    q = skipBlanks(q, lineEnd);
+                }
+                for (int k = 1; k+1 < (int) polygon.size(); ++k)
+                {
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[k]);
+                    chunk.corners.push_back(polygon[k+1]);
+                }
+            }
+            p = lineEnd + 1;
+        }
+        return true;
+    }
+
+    bool merge(std::vector<Chunk> &chunks)
+    {
+        /**
+         * Chunk arrays concatenated in file order, relative indices resolved with the offsets of their chunk
+        */
+        std::vector<glm::ivec3> offsets(chunks.size()+1, glm::ivec3(0)); // positions, uvs, normals
+        std::vector<size_t> cornerOffsets(chunks.size()+1, 0);
+        for (int t = 0; t < (int) chunks.size(); ++t)
+        {
+            offsets[t+1] = offsets[t] + glm::ivec3(chunks[t].positions.size(), chunks[t].uvs.size(), chunks[t].normals.size());
+            cornerOffsets[t+1] = cornerOffsets[t] + chunks[t].corners.size();
+        }
+        glm::ivec3 counts = offsets.back();
+        m_positions.resize(counts.x);
+        m_uvs.resize(counts.y);
+        m_normals.resize(counts.z);
+        m_corners.resize(cornerOffsets.back());
+
+        std::vector<char> isValid(chunks.size(), 1);
+        parallelRanges(m_nbThreads, chunks.size(), [&](size_t begin, size_t end, int) {
+            for (size_t t = begin; t < end; ++t)
+            {
+                const Chunk &chunk = chunks[t];
+                std::copy(chunk.positions.begin(), chunk.positions.end(), m_positions.begin() + offsets[t].x);
+                std::copy(chunk.uvs.begin(), chunk.uvs.end(), m_uvs.begin() + offsets[t].y);
+                std::copy(chunk.normals.begin(), chunk.normals.end(), m_normals.begin() + offsets[t].z);
+                for (size_t c = 0; c < chunk.corners.size(); ++c)
+                {
+                    OBJCorner corner = {decodeIndex(chunk.corners[c].v, offsets[t].x), decodeIndex(chunk.corners[c].vt, offsets[t].y),
+                        decodeIndex(chunk.corners[c].vn, offsets[t].z)};
+                    if (corner.v < 0 || corner.v >= counts.x || corner.vt < OBJ_NO_INDEX || corner.vt >= counts.y || corner.vn < OBJ_NO_INDEX
+                        || corner.vn >= counts.z) isValid[t] = 0;
+                    m_corners[cornerOffsets[t] + c] = corner;
+                }
+            }
+        });
+        return std::find(isValid.begin(), isValid.end(), 0) == isValid.end();
+    }
+
+    bool sameVertex(int c0, int c1) const
+    {
+        const OBJCorner &a = m_corners[c0], &b = m_corners[c1];
+        if (m_positions[a.v] != m_positions[b.v]) return false;
+        if ((a.vt < 0) != (b.vt < 0) || (a.vt >= 0 && m_uvs[a.vt] != m_uvs[b.vt])) return false;
+        if ((a.vn < 0) != (b.vn < 0) || (a.vn >= 0 && m_normals[a.vn] != m_normals[b.vn])) return false;
+        return true;
+    }
+
+    uint64_t hashCorner(int c) const
+    {
+        const OBJCorner &corner = m_corners[c];
+        float values[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+        std::memcpy(values, &m_positions[corner.v], sizeof(glm::vec3));
+        if (corner.vt >= 0) std::memcpy(values+3, &m_uvs[corner.vt], sizeof(glm::vec2));
+        if (corner.vn >= 0) std::memcpy(values+5, &m_normals[corner.vn], sizeof(glm::vec3));
+        for (float &value : values) if (value == 0.0f) value = 0.0f; // (-0 == +0 for sameVertex : same bits)
+
+        uint64_t h = 1469598103934665603ull; // FNV-1a over the value bits
+        const unsigned char *bytes = (const unsigned char *) values;
+        for (int k = 0; k < (int) sizeof(values); ++k) h = (h ^ bytes[k])*1099511628211ull;
+        return h ^ (h >> 29);
+    }
+
+    bool weld(OBJMesh &mesh)
+    {
+        int nbCorners = m_corners.size();
+        size_t tableSize = 1;
+        while (tableSize < 2*(size_t) nbCorners) tableSize <<= 1;
+        std::unique_ptr<std::atomic<int>[]> table(new std::atomic<int>[tableSize]);
+        for (size_t s = 0; s < tableSize; ++s) table[s].store(-1, std::memory_order_relaxed);
+
+        // insertion : the slot of a vertex ends up holding its smallest corner
+        std::vector<size_t> slots(nbCorners);
+        parallelRanges(m_nbThreads, nbCorners, [&](size_t begin, size_t end, int) {
+            for (size_t c = begin; c < end; ++c)
+            {
+                size_t s = hashCorner(c) & (tableSize-1);
+                int cur = table[s].load();
+                while (true)
+                {
+                    if (cur < 0)
+                    {
+                        if (table[s].compare_exchange_weak(cur, (int) c)) break;
+                        continue; // cur reloaded
+                    }
+                    if (sameVertex(cur, c))
+                    {
+                        while ((int) c < cur && !table[s].compare_exchange_weak(cur, (int) c)) {}
+                        break;
+                    }
+                    s = (s+1) & (tableSize-1);
+                    cur = table[s].load();
+                }
+                slots[c] = s;
+            }
+        });
+
+        // vertex ids in the order of the first corners (prefix sum over the threads' ranges)
+        std::vector<int> ids(nbCorners);
+        std::vector<int> nbFirst(m_nbThreads+1, 0);
+        parallelRanges(m_nbThreads, nbCorners, [&](size_t begin, size_t end, int t) {
+            for (size_t c = begin; c < end; ++c) nbFirst[t+1] += (table[slots[c]].load() == (int) c);
+        });
+        for (int t = 0; t < m_nbThreads; ++t) nbFirst[t+1] += nbFirst[t];
+        int nbVertices = nbFirst[m_nbThreads];
+
+        bool hasUVs = !m_uvs.empty(), hasNormals = !m_normals.empty();
+        mesh.positions.resize(nbVertices);
+        mesh.uvs.assign(hasUVs ? nbVertices : 0, glm::vec2(0.0f));
+        mesh.normals.assign(hasNormals ? nbVertices : 0, glm::vec3(0.0f));
+        parallelRanges(m_nbThreads, nbCorners, [&](size_t begin, size_t end, int t) {
+            int id = nbFirst[t];
+            for (size_t c = begin; c < end; ++c)
+            {
+                if (table[slots[c]].load() != (int) c) continue;
+                const OBJCorner &corner = m_corners[c];
+                mesh.positions[id] = m_positions[corner.v];
+                if (hasUVs && corner.vt >= 0) mesh.uvs[id] = m_uvs[corner.vt];
+                if (hasNormals && corner.vn >= 0) mesh.normals[id] = m_normals[corner.vn];
+                ids[c] = id++;
+            }
+        });
+
+        mesh.indices.resize(nbCorners);
+        parallelRanges(m_nbThreads, nbCorners, [&](size_t begin, size_t end, int) {
+            for (size_t c = begin; c < end; ++c) mesh.indices[c] = ids[table[slots[c]].load()];
+        });
+        mesh.nbCorners = nbCorners;
+        return nbCorners > 0;
+    }
+
+    int m_nbThreads;
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_normals;
+    std::vector<glm::vec2> m_uvs;
+    std::vector<OBJCorner> m_corners;
+};
+
+#endif
@@ -0,0 +1,425 @@
+#ifndef PLY_MMAP_H
+#define PLY_MMAP_H
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include "glm/glm.hpp"
+#include "mapped_file.h"
+
+enum PLYType
+{
+    PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64, PLY_INVALID
+};
+
+inline PLYType plyType(const std::string &name)
+{
+    if (name == "char" || name == "int8") return PLY_INT8;
+    if (name == "uchar" || name == "uint8") return PLY_UINT8;
+    if (name == "short" || name == "int16") return PLY_INT16;
+    if (name == "ushort" || name == "uint16") return PLY_UINT16;
+    if (name == "int" || name == "int32") return PLY_INT32;
+    if (name == "uint" || name == "uint32") return PLY_UINT32;
+    if (name == "float" || name == "float32") return PLY_FLOAT32;
+    if (name == "double" || name == "float64") return PLY_FLOAT64;
+    return PLY_INVALID;
+}
+
+inline int plySize(PLYType type)
+{
+    static const int sizes[] = {1, 1, 2, 2, 4, 4, 4, 8, 0};
+    return sizes[type];
+}
+
+inline double plyRead(const char *p, PLYType type)
+{
+    // little endian scalar of any type, from a possibly unaligned address
+    switch (type)
+    {
+        case PLY_INT8: {int8_t x; std::memcpy(&x, p, 1); return x;}
+        case PLY_UINT8: {uint8_t x; std::memcpy(&x, p, 1); return x;}
+        case PLY_INT16: {int16_t x; std::memcpy(&x, p, 2); return x;}
+        case PLY_UINT16: {uint16_t x; std::memcpy(&x, p, 2); return x;}
+        case PLY_INT32: {int32_t x; std::memcpy(&x, p, 4); return x;}
+        case PLY_UINT32: {uint32_t x; std::memcpy(&x, p, 4); return x;}
+        case PLY_FLOAT32: {float x; std::memcpy(&x, p, 4); return x;}
+        case PLY_FLOAT64: {double x; std::memcpy(&x, p, 8); return x;}
+        default: return 0.0;
+    }
+}
+
+struct PLYProperty
+{
+    std::string name;
+    PLYType type; // type of the list items for lists
+    PLYType countType; // lists only
+    bool isList;
+    int offset; // in the element's record, -1 after a list (variable offset)
+};
+
+struct PLYElement
+{
+    std::string name;
+    size_t count;
+    std::vector<PLYProperty> properties;
+    int stride; // record size, -1 when it has lists
+
+    int property(const std::string &name) const
+    {
+        for (int k = 0; k < (int) properties.size(); ++k) if (properties[k].name == name) return k;
+        return -1;
+    }
+};
+
+class PLYMapping
+{
+    /**
+     * PLY file read in place from its mapping. The header is validated, then the vertices and faces are read in a single
+     * pass : straight from the mapped records for binary little endian files (positions and normals through their
+     * offsets in fixed size records, faces by walking their lists), through one converting parse for ascii files.
+     * Big endian files are not supported (isValid() is false, the caller falls back to its generic loader).
+     * The mapping is not exposed : read() copies the transformed positions, normals and indices into the caller's vectors.
+    */
+    public:
+    PLYMapping(const std::string &path) : m_file(path), m_isValid(false), m_isBinary(false), m_body(nullptr)
+    {
+        if (m_file.isOpen()) m_isValid = parseHeader();
+    }
+
+    bool isValid() const {return m_isValid;};
+    bool isBinary() const {return m_isBinary;};
+    size_t fileSize() const {return m_file.size();};
+
+    const PLYElement *element(const std::string &name) const
+    {
+        for (const PLYElement &e : m_elements) if (e.name == name) return &e;
+        return nullptr;
+    }
+
+    bool read(const glm::mat4 &model, std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals, std::vector<unsigned int> &indices) const
+    {
+        /**
+         * Transformed positions and normals (empty if the file has none) + triangles (polygons are split in fans)
+        */
+        if (!m_isValid || !element("vertex") || !element("face")) return false;
+        return m_isBinary ? readBinary(model, positions, normals, indices) : readASCII(model, positions, normals, indices);
+    }
+
+    private:
+    const glm::vec3 *positions() const
+    {
+        /**
+         * Tightly packed float x, y, z vertex records seen as positions (nullptr otherwise) : the fast path of readBinary,
+         * which still copies them (transformed) into the caller's vector
+        */
+        const PLYElement *vertex = element("vertex");
+        if (!m_isBinary || !vertex || vertex->stride != 3*sizeof(float) || !isFloatTriple(*vertex, "x", "y", "z")) return nullptr;
+        if (((uintptr_t) elementData(*vertex)) % alignof(float) != 0) return nullptr;
+        return (const glm::vec3 *) elementData(*vertex);
+    }
+
+    bool parseHeader()
+    {
+        const char *data = m_file.data();
+        size_t size = m_file.size();
+        const char *marker = "end_header";
+        const char *end = nullptr;
+        for (size_t k = 0; k + 10 <= size && k < (1 << 16); ++k)
+        {
+            if (std::memcmp(data + k, marker, 10) == 0 && (k == 0 || data[k-1] == '\n')) {end = data + k; break;}
+        }
+        if (size < 3 || std::memcmp(data, "ply", 3) != 0 || !end) return false;
+
+        m_body = end + 10;
+        while (m_body < data + size && *m_body != '\n') m_body++;
+        if (m_body == data + size) return false;
+        m_body++;
+
+        std::istringstream header(std::string(data, end - data));
+        std::string line;
+        while (std::getline(header, line))
+        {
+            std::istringstream tokens(line);
+            std::string keyword;
+            tokens >> keyword;
+            if (keyword == "format")
+            {
+                std::string format;
+                tokens >> format;
+                if (format == "binary_little_endian") m_isBinary = true;
+                else if (format != "ascii") return false;
+            }
+            else if (keyword == "element")
+            {
+                PLYElement e;
+                tokens >> e.name >> e.count;
+                e.stride = 0;
+                m_elements.push_back(e);
+            }
+            else if (keyword == "property")
+            {
+                if (m_elements.empty()) return false;
+                PLYElement &e = m_elements.back();
+                PLYProperty p;
+                std::string type;
+                tokens >> type;
+                p.isList = (type == "list");
+                if (p.isList)
+                {
+                    std::string countType, itemType;
+                    tokens >> countType >> itemType;
+                    p.countType = plyType(countType);
+                    p.type = plyType(itemType);
+                    if (p.countType == PLY_INVALID || p.countType == PLY_FLOAT32 || p.countType == PLY_FLOAT64) return false;
+                }
+                else
+                {
+                    p.type = plyType(type);
+                    p.countType = PLY_INVALID;
+                }
+                if (p.type == PLY_INVALID) return false;
+                tokens >> p.name;
+
+                p.offset = e.stride;
+                if (e.stride >= 0) e.stride = p.isList ? -1 : e.stride + plySize(p.type);
+                e.properties.push_back(p);
+            }
+        }
+
+        if (m_isBinary)
+        {
+            // start of each element's records (walking the ones with lists)
+            const char *p = m_body;
+            for (PLYElement &e : m_elements)
+            {
+                m_elementData.push_back(p);
+                if (e.stride >= 0) p += e.count*e.stride;
+                else for (size_t k = 0; k < e.count && p; ++k) p = skipRecord(e, p);
+                if (!p || p > data + size) return false;
+            }
+        }
+        return true;
+    }
+
+    const char *elementData(const PLYElement &e) const
+    {
+        return m_elementData[&e - m_elements.data()];
+    }
+
+    const char *skipRecord(const PLYElement &e, const char *p) const
+    {
+        const char *end = m_file.data() + m_file.size();
+        for (const PLYProperty &prop : e.properties)
+        {
+            if (prop.isList)
+            {
+                if (p + plySize(prop.countType) > end) return nullptr;
+                size_t n = (size_t) plyRead(p, prop.countType);
+                p += plySize(prop.countType) + n*plySize(prop.type);
+            }
+            else p += plySize(prop.type);
+            if (p > end) return nullptr;
+        }
+        return p;
+    }
+
+    static bool isFloatTriple(const PLYElement &e, const char *a, const char *b, const char *c)
+    {
+        int i = e.property(a), j = e.property(b), k = e.property(c);
+        if (i < 0 || j < 0 || k < 0) return false;
+        const PLYProperty &x = e.properties[i], &y = e.properties[j], &z = e.properties[k];
+        return x.type == PLY_FLOAT32 && y.type == PLY_FLOAT32 && z.type == PLY_FLOAT32 && x.offset >= 0 &&
+            y.offset == x.offset + 4 && z.offset == x.offset + 8;
+    }
+
+    static glm::mat3 normalMatrix(const glm::mat4 &model)
+    {
+        glm::mat3 m(model);
+        return glm::determinant(m) != 0.0f ? glm::transpose(glm::inverse(m)) : glm::mat3(1.0f);
+    }
+
+    static void addPolygon(const unsigned int *polygon, int n, std::vector<unsigned int> &indices)
+    {
+        for (int k = 1; k+1 < n; ++k)
+        {
+            indices.push_back(polygon[0]);
+            indices.push_back(polygon[k]);
+            indices.push_back(polygon[k+1]);
+        }
+    }
+
+    bool readBinary(const glm::mat4 &model, std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals, std::vector<unsigned int> &indices) const
+    {
+        const PLYElement &vertex = *element("vertex");
+        const PLYElement &face = *element("face");
+        if (vertex.stride < 0 || vertex.property("x") < 0 || vertex.property("y") < 0 || vertex.property("z") < 0) return false;
+
+        // vertices : fixed size records
+        const char *records = elementData(vertex);
+        const PLYProperty &x = vertex.properties[vertex.property("x")];
+        const PLYProperty &y = vertex.properties[vertex.property("y")];
+        const PLYProperty &z = vertex.properties[vertex.property("z")];
+        const glm::vec3 *mapped = this->positions();
+        bool isPacked = isFloatTriple(vertex, "x", "y", "z");
+        positions.resize(vertex.count);
+        for (size_t k = 0; k < vertex.count; ++k)
+        {
+            const char *r = records + k*vertex.stride;
+            glm::vec3 p;
+            if (mapped) p = mapped[k];
+            else if (isPacked) std::memcpy(&p, r + x.offset, sizeof(glm::vec3));
+            else p = glm::vec3(plyRead(r + x.offset, x.type), plyRead(r + y.offset, y.type), plyRead(r + z.offset, z.type));
+            positions[k] = glm::vec3(model*glm::vec4(p, 1.0f));
+        }
+
+        normals.clear();
+        if (vertex.property("nx") >= 0 && vertex.property("ny") >= 0 && vertex.property("nz") >= 0)
+        {
+            const PLYProperty &nx = vertex.properties[vertex.property("nx")];
+            const PLYProperty &ny = vertex.properties[vertex.property("ny")];
+            const PLYProperty &nz = vertex.properties[vertex.property("nz")];
+            glm::mat3 normalMat = normalMatrix(model);
+            normals.resize(vertex.count);
+            for (size_t k = 0; k < vertex.count; ++k)
+            {
+                const char *r = records + k*vertex.stride;
+                normals[k] = normalMat*glm::vec3(plyRead(r + nx.offset, nx.type), plyRead(r + ny.offset, ny.type), plyRead(r + nz.offset, nz.type));
+            }
+        }
+
+        // faces : their lists are walked (records of variable size)
+        int listIdx = face.property("vertex_indices");
+        if (listIdx < 0) listIdx = face.property("vertex_index");
+        if (listIdx < 0 || !face.properties[listIdx].isList) return false;
+
+        const char *p = elementData(face);
+        const char *end = m_file.data() + m_file.size();
+        indices.clear();
+        indices.reserve(3*face.count);
+        std::vector<unsigned int> polygon;
+        for (size_t f = 0; f < face.count; ++f)
+        {
+            for (int k = 0; k < (int) face.properties.size(); ++k)
+            {
+                const PLYProperty &prop = face.properties[k];
+                if (!prop.isList)
+                {
+                    p += plySize(prop.type);
+                    continue;
+                }
+                if (p + plySize(prop.countType) > end) return false;
+                size_t n = (size_t) plyRead(p, prop.countType);
+                p += plySize(prop.countType);
+                if (p + n*plySize(prop.type) > end) return false;
+                if (k == listIdx)
+                {
+                    polygon.resize(n);
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        polygon[i] = (unsigned int) plyRead(p + i*plySize(prop.type), prop.type);
+                        if (polygon[i] >= vertex.count) return false;
+                    }
+                    addPolygon(polygon.data(), n, indices);
+                }
+                p += n*plySize(prop.type);
+            }
+        }
+        return true;
+    }
+
+    bool readASCII(const glm::mat4 &model, std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals, std::vector<unsigned int> &indices) const
+    {
+        /**
+         * Converting pass : one token per scalar, records on their own lines
+        */
+        const char *p = m_body;
+        const char *end = m_file.data() + m_file.size();
+        glm::mat3 normalMat = normalMatrix(model);
+        std::vector<double> values;
+        std::vector<unsigned int> polygon;
+
+        for (const PLYElement &e : m_elements)
+        {
+            bool isVertex = (e.name == "vertex");
+            bool isFace = (e.name == "face");
+            int ix = e.property("x"), iy = e.property("y"), iz = e.property("z");
+            int inx = e.property("nx"), iny = e.property("ny"), inz = e.property("nz");
+            bool hasNormals = inx >= 0 && iny >= 0 && inz >= 0;
+            int listIdx = e.property("vertex_indices");
+            if (listIdx < 0) listIdx = e.property("vertex_index");
+            if (isVertex && (ix < 0 || iy < 0 || iz < 0)) return false;
+            if (isFace && (listIdx < 0 || !e.properties[listIdx].isList)) return false;
+            if (isVertex)
+            {
+                positions.resize(e.count);
+                normals.resize(hasNormals ? e.count : 0);
+            }
+            if (isFace) indices.reserve(3*e.count);
+
+            for (size_t r = 0; r < e.count; ++r)
+            {
+                if (!isVertex && !isFace)
+                {
+                    while (p < end && *p != '\n') p++; // record of an element we do not need
+                    p++;
+                    continue;
+                }
+                values.clear();
+                for (int k = 0; k < (int) e.properties.size(); ++k)
+                {
+                    double value;
+                    if (!nextNumber(p, end, value)) return false;
+                    if (!e.properties[k].isList)
+                    {
+                        values.push_back(value);
+                        continue;
+                    }
+                    size_t n = (size_t) value;
+                    if (isFace && k == listIdx) polygon.resize(n);
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        if (!nextNumber(p, end, value)) return false;
+                        if (isFace && k == listIdx)
+                        {
+                            if (value < 0.0 || value >= (double) positions.size()) return false;
+                            polygon[i] = (unsigned int) value;
+                        }
+                    }
+                    values.push_back(0.0);
+                }
+                if (isVertex)
+                {
+                    positions[r] = glm::vec3(model*glm::vec4(values[ix], values[iy], values[iz], 1.0f));
+                    if (hasNormals) normals[r] = normalMat*glm::vec3(values[inx], values[iny], values[inz]);
+                }
+                else addPolygon(polygon.data(), polygon.size(), indices);
+            }
+        }
+        return !positions.empty();
+    }
+
+    static bool nextNumber(const char *&p, const char *end, double &value)
+    {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+        char token[64];
+        int n = 0;
+        while (p < end && n < 63 && !(*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) token[n++] = *p++;
+        if (n == 0) return false;
+        token[n] = '\0';
+        char *parsed;
+        value = std::strtod(token, &parsed);
+        return parsed != token;
+    }
+
+    MappedFile m_file;
+    bool m_isValid;
+    bool m_isBinary;
+    const char *m_body; // first byte after the header
+    std::vector<PLYElement> m_elements;
+    std::vector<const char *> m_elementData; // binary : first record of each element
+};
+
+#endif
@@ -0,0 +1,510 @@
+#ifndef POINT_CACHE_H
+#define POINT_CACHE_H
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "rans.h"
+#include "mapped_file.h"
+
+// Compressed point cache of the cloth : one frame of positions after the other, streamed to the file as they come.
+// A frame is quantized on 'bits' bits per axis inside its own bounding box, each value is predicted (from its
+// neighbours in the frame, from the previous frame or linearly from the two previous ones, whichever is the cheapest),
+// and the residuals are coded as a bucket (number of significant bits, rANS with one static model per axis) followed by
+// its raw mantissa bits. Every keyframeInterval frames the frame only uses the spatial prediction : seeking decodes at
+// most keyframeInterval frames, found through the offsets table written at the end of the file.
+// With bits = CACHE_RAW_BITS the frames are stored as glm::vec3 arrays instead : 12 bytes per vertex, but a frame is
+// read straight from the mapped file (playback and scrubbing, see cache_playback.hcu).
+
+const char POINT_CACHE_MAGIC[8] = {'C', 'L', 'O', 'T', 'H', 'P', 'C', '1'};
+const uint32_t POINT_CACHE_VERSION = 1;
+const int CACHE_NB_BUCKETS = 33; // 0 : zero residual, b : residual with b significant bits (zigzag coded)
+const uint32_t CACHE_MAX_BITS = 24;
+const uint32_t CACHE_RAW_BITS = 32; // uncompressed frames
+
+enum CachePredictor
+{
+    CACHE_SPATIAL, // parallelogram on the cloth grid (previous vertex if the vertices are not a grid)
+    CACHE_TEMPORAL, // previous frame
+    CACHE_LINEAR, // 2*previous - before previous (constant velocity)
+    CACHE_RAW, // no prediction : the positions follow the frame header (rawBytes)
+    CACHE_NB_PREDICTORS
+};
+
+struct PointCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t nbVertices;
+    uint32_t gridN; // vertices per edge when the vertices are a N*N grid (Plane layout), 0 otherwise
+    uint32_t bits;
+    uint32_t keyframeInterval;
+    uint32_t nbFrames;
+    float frameTime; // simulated time between two frames (in s)
+    uint32_t padding;
+    uint64_t indexOffset; // nbFrames offsets (uint64) of the frames, written when the cache is closed
+};
+
+struct CacheFrameHeader
+{
+    float boundsMin[3];
+    float step[3]; // quantization step along each axis : the reconstruction error is at most step/2
+    uint32_t predictor;
+    uint32_t ransBytes;
+    uint32_t rawBytes;
+    uint16_t freqs[3][CACHE_NB_BUCKETS];
+    uint16_t padding;
+};
+
+inline int cacheBits(int bits)
+{
+    return bits >= (int) CACHE_RAW_BITS ? CACHE_RAW_BITS : std::min<int>(std::max(bits, 1), CACHE_MAX_BITS);
+}
+
+inline int cacheQuantize(float p, float boundsMin, float step, int maxQ)
+{
+    double q = std::floor((double(p) - boundsMin)/step + 0.5);
+    return (int) std::min<double>(std::max<double>(q, 0.0), maxQ);
+}
+
+inline float cacheDequantize(int q, float boundsMin, float step)
+{
+    return float(double(boundsMin) + double(q)*step);
+}
+
+inline int cacheBucket(uint32_t u)
+{
+    return u == 0 ? 0 : 32 - __builtin_clz(u);
+}
+
+inline uint32_t cacheZigzag(int r)
+{
+    return ((uint32_t) r << 1) ^ (uint32_t) (r >> 31);
+}
+
+class PointCacheCodec
+{
+    /**
+     * State shared by the encoder and the decoder : both predict from the reconstructed positions of the previous
+     * frames, so that they stay in sync whatever the prediction used
+    */
+    public:
+    PointCacheCodec(int nbVertices, int gridN, int bits) : m_models(3)
+    {
+        init(nbVertices, gridN, bits);
+    }
+
+    void init(int nbVertices, int gridN, int bits)
+    {
+        m_nbVertices = nbVertices;
+        m_gridN = gridN;
+        m_maxQ = (1 << bits) - 1;
+        m_nbPrevFrames = 0;
+        m_q.assign(3*nbVertices, 0);
+        m_prev.assign(nbVertices, glm::vec3(0.0f));
+        m_prevPrev.assign(nbVertices, glm::vec3(0.0f));
+    }
+
+    void reset() {m_nbPrevFrames = 0;};
+
+    int predict(int predictor, int k, int axis, const CacheFrameHeader &frame)
+    {
+        if (predictor == CACHE_TEMPORAL) return cacheQuantize(m_prev[k][axis], frame.boundsMin[axis], frame.step[axis], m_maxQ);
+        if (predictor == CACHE_LINEAR)
+        {
+            float linear = 2.0f*m_prev[k][axis] - m_prevPrev[k][axis];
+            return cacheQuantize(linear, frame.boundsMin[axis], frame.step[axis], m_maxQ);
+        }
+
+        // spatial : values already (de)coded in this frame
+        int *q = m_q.data();
+        if (m_gridN <= 0) return k > 0 ? q[3*(k-1) + axis] : 0;
+        int i = k%m_gridN;
+        int j = k/m_gridN;
+        if (i > 0 && j > 0)
+        {
+            int pred = q[3*(k-1) + axis] + q[3*(k-m_gridN) + axis] - q[3*(k-m_gridN-1) + axis];
+            return std::min(std::max(pred, 0), m_maxQ);
+        }
+        if (i > 0) return q[3*(k-1) + axis];
+        if (j > 0) return q[3*(k-m_gridN) + axis];
+        return 0;
+    }
+
+    void endFrame(const CacheFrameHeader &frame, glm::vec3 *positions)
+    {
+        /**
+         * Reconstructs the positions from the quantized values and shifts the history
+        */
+        m_prevPrev.swap(m_prev);
+        for (int k = 0; k < m_nbVertices; ++k)
+        {
+            for (int axis = 0; axis < 3; ++axis) m_prev[k][axis] = cacheDequantize(m_q[3*k + axis], frame.boundsMin[axis], frame.step[axis]);
+        }
+        if (positions) memcpy(positions, m_prev.data(), sizeof(glm::vec3)*m_nbVertices);
+        m_nbPrevFrames = std::min(m_nbPrevFrames + 1, 2);
+    }
+
+    protected:
+    int m_nbVertices;
+    int m_gridN;
+    int m_maxQ;
+    int m_nbPrevFrames;
+    std::vector<int> m_q; // quantized values of the current frame
+    std::vector<glm::vec3> m_prev; // reconstructed positions of the previous frame
+    std::vector<glm::vec3> m_prevPrev;
+    std::vector<RansModel> m_models;
+};
+
+class PointCacheWriter : public PointCacheCodec
+{
+    public:
+    PointCacheWriter(const std::string &path, int nbVertices, int gridN = 0, int bits = 16, int keyframeInterval = 30, float frameTime = 0.0f)
+    : PointCacheCodec(nbVertices, gridN, std::min<int>(cacheBits(bits), CACHE_MAX_BITS)),
+    m_file(fopen(path.c_str(), "wb")),
+    m_rawBytes(0),
+    m_encodedBytes(0),
+    m_maxError(0.0f),
+    m_residuals(3*nbVertices)
+    {
+        memset(&m_header, 0, sizeof(PointCacheHeader));
+        memcpy(m_header.magic, POINT_CACHE_MAGIC, sizeof(POINT_CACHE_MAGIC));
+        m_header.version = POINT_CACHE_VERSION;
+        m_header.nbVertices = nbVertices;
+        m_header.gridN = gridN*gridN == nbVertices ? gridN : 0;
+        m_header.bits = cacheBits(bits);
+        m_header.keyframeInterval = m_header.bits == CACHE_RAW_BITS ? 1 : std::max(keyframeInterval, 1);
+        m_header.frameTime = frameTime;
+        m_gridN = m_header.gridN;
+        if (m_file && fwrite(&m_header, sizeof(PointCacheHeader), 1, m_file) != 1) closeFile();
+    }
+
+    ~PointCacheWriter()
+    {
+        close();
+    }
+
+    bool isOpen() {return m_file != nullptr;};
+
+    bool writeFrame(const glm::vec3 *positions)
+    {
+        /**
+         * Encodes a frame and appends it to the file. Fails on non-finite positions (the frame is not written).
+        */
+        if (!m_file) return false;
+        CacheFrameHeader frame;
+        memset(&frame, 0, sizeof(CacheFrameHeader));
+        if (m_header.bits == CACHE_RAW_BITS) return writeRawFrame(positions, frame);
+        if (!quantizeFrame(positions, frame)) return false;
+
+        if (m_header.nbFrames % m_header.keyframeInterval == 0) reset(); // (the frames after a keyframe do not look behind it)
+        frame.predictor = choosePredictor(m_nbPrevFrames, frame);
+        std::vector<uint8_t> bytes;
+        encodeResiduals(frame, bytes);
+
+        m_offsets.push_back(ftell(m_file));
+        if (fwrite(&frame, sizeof(CacheFrameHeader), 1, m_file) != 1 || fwrite(bytes.data(), 1, bytes.size(), m_file) != bytes.size())
+        {
+            closeFile();
+            return false;
+        }
+
+        endFrame(frame, nullptr);
+        for (int k = 0; k < m_nbVertices; ++k) m_maxError = std::max(m_maxError, glm::length(m_prev[k] - positions[k]));
+        m_header.nbFrames++;
+        m_rawBytes += sizeof(glm::vec3)*m_nbVertices;
+        m_encodedBytes += sizeof(CacheFrameHeader) + bytes.size();
+        return true;
+    }
+
+    bool close()
+    {
+        /**
+         * Writes the offsets of the frames and completes the header
+        */
+        if (!m_file) return false;
+        m_header.indexOffset = ftell(m_file);
+        bool isValid = fwrite(m_offsets.data(), sizeof(uint64_t), m_offsets.size(), m_file) == m_offsets.size();
+        isValid = isValid && fseek(m_file, 0, SEEK_SET) == 0 && fwrite(&m_header, sizeof(PointCacheHeader), 1, m_file) == 1;
+        isValid = (fclose(m_file) == 0) && isValid;
+        m_file = nullptr;
+        return isValid;
+    }
+
+    int nbFrames() {return m_header.nbFrames;};
+    size_t rawBytes() {return m_rawBytes;}; // size of the frames as glm::vec3 arrays
+    size_t encodedBytes() {return m_encodedBytes;};
+    float maxError() {return m_maxError;}; // largest distance between a position and its reconstruction
+
+    private:
+    FILE *m_file;
+    PointCacheHeader m_header;
+    std::vector<uint64_t> m_offsets;
+    size_t m_rawBytes;
+    size_t m_encodedBytes;
+    float m_maxError;
+    std::vector<int> m_residuals;
+
+    void closeFile()
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+
+    bool writeRawFrame(const glm::vec3 *positions, CacheFrameHeader &frame)
+    {
+        for (int k = 0; k < m_nbVertices; ++k)
+        {
+            const glm::vec3 &p = positions[k];
+            if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) return false;
+        }
+        frame.predictor = CACHE_RAW;
+        frame.rawBytes = sizeof(glm::vec3)*m_nbVertices;
+
+        m_offsets.push_back(ftell(m_file));
+        if (fwrite(&frame, sizeof(CacheFrameHeader), 1, m_file) != 1 || fwrite(positions, sizeof(glm::vec3), m_nbVertices, m_file) != (size_t) m_nbVertices)
+        {
+            closeFile();
+            return false;
+        }
+        m_header.nbFrames++;
+        m_rawBytes += frame.rawBytes;
+        m_encodedBytes += sizeof(CacheFrameHeader) + frame.rawBytes;
+        return true;
+    }
+
+    bool quantizeFrame(const glm::vec3 *positions, CacheFrameHeader &frame)
+    {
+        glm::vec3 boundsMin(1e30f), boundsMax(-1e30f);
+        for (int k = 0; k < m_nbVertices; ++k)
+        {
+            const glm::vec3 &p = positions[k];
+            if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) return false;
+            boundsMin = glm::min(boundsMin, p);
+            boundsMax = glm::max(boundsMax, p);
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float extent = boundsMax[axis] - boundsMin[axis];
+            frame.boundsMin[axis] = boundsMin[axis];
+            frame.step[axis] = extent > 0.0f ? extent/m_maxQ : 1.0f;
+        }
+        for (int k = 0; k < m_nbVertices; ++k)
+        {
+            for (int axis = 0; axis < 3; ++axis) m_q[3*k + axis] = cacheQuantize(positions[k][axis], frame.boundsMin[axis], frame.step[axis], m_maxQ);
+        }
+        return true;
+    }
+
+    int choosePredictor(int nbPrevFrames, const CacheFrameHeader &frame)
+    {
+        /**
+         * Predictor with the smallest estimated size (sum of the significant bits of the residuals, on a subset of the
+         * vertices : every prediction only reads values already quantized)
+        */
+        const int stride = 7;
+        int best = CACHE_SPATIAL;
+        uint64_t bestCost = UINT64_MAX;
+        for (int predictor = 0; predictor <= nbPrevFrames; ++predictor)
+        {
+            uint64_t cost = 0;
+            for (int k = 0; k < m_nbVertices; k += stride)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    int r = m_q[3*k + axis] - predict(predictor, k, axis, frame);
+                    cost += cacheBucket(cacheZigzag(r));
+                }
+            }
+            if (cost < bestCost)
+            {
+                best = predictor;
+                bestCost = cost;
+            }
+        }
+        return best;
+    }
+
+    void encodeResiduals(CacheFrameHeader &frame, std::vector<uint8_t> &bytes)
+    {
+        std::vector<uint32_t> counts[3];
+        for (int axis = 0; axis < 3; ++axis) counts[axis].assign(CACHE_NB_BUCKETS, 0);
+        for (int k = 0; k < m_nbVertices; ++k)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                int r = m_q[3*k + axis] - predict(frame.predictor, k, axis, frame);
+                uint32_t u = cacheZigzag(r);
+                m_residuals[3*k + axis] = u;
+                counts[axis][cacheBucket(u)]++;
+            }
+        }
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            m_models[axis].normalize(counts[axis]);
+            memcpy(frame.freqs[axis], m_models[axis].freqs.data(), sizeof(uint16_t)*CACHE_NB_BUCKETS);
+        }
+
+        // buckets : rANS, in reverse order
+        RansEncoder encoder;
+        for (int idx = 3*m_nbVertices - 1; idx >= 0; --idx) encoder.put(m_models[idx%3], cacheBucket(m_residuals[idx]));
+        encoder.finish(bytes);
+        frame.ransBytes = bytes.size();
+
+        // mantissas : raw bits, in order
+        uint64_t bits = 0;
+        int nbBits = 0;
+        for (int idx = 0; idx < 3*m_nbVertices; ++idx)
+        {
+            uint32_t u = m_residuals[idx];
+            int bucket = cacheBucket(u);
+            if (bucket <= 1) continue;
+            bits |= (uint64_t) (u & ((1u << (bucket-1)) - 1)) << nbBits;
+            nbBits += bucket-1;
+            for (; nbBits >= 8; nbBits -= 8, bits >>= 8) bytes.push_back(bits & 0xff);
+        }
+        if (nbBits > 0) bytes.push_back(bits & 0xff);
+        frame.rawBytes = bytes.size() - frame.ransBytes;
+    }
+};
+
+class PointCacheReader : public PointCacheCodec
+{
+    /**
+     * Random access to the frames of a mapped cache : the offsets table gives the frame directly, which is decoded
+     * from the closest keyframe before it, or from the last decoded frame when reading forward. Raw frames are not
+     * decoded at all (see framePositions).
+    */
+    public:
+    PointCacheReader(const std::string &path)
+    : PointCacheCodec(0, 0, 1), m_file(path), m_isValid(false), m_lastFrame(-1)
+    {
+        if (!m_file.isOpen() || m_file.size() < sizeof(PointCacheHeader)) return;
+        memcpy(&m_header, m_file.data(), sizeof(PointCacheHeader));
+        m_isValid = memcmp(m_header.magic, POINT_CACHE_MAGIC, sizeof(POINT_CACHE_MAGIC)) == 0 && m_header.version == POINT_CACHE_VERSION
+            && cacheBits(m_header.bits) == (int) m_header.bits && m_header.keyframeInterval > 0 && m_header.indexOffset > 0
+            && m_header.indexOffset + sizeof(uint64_t)*m_header.nbFrames <= m_file.size();
+        if (!m_isValid) return;
+
+        m_offsets.resize(m_header.nbFrames);
+        memcpy(m_offsets.data(), m_file.data() + m_header.indexOffset, sizeof(uint64_t)*m_header.nbFrames); // (not aligned in the file)
+        init(m_header.nbVertices, m_header.gridN, std::min(m_header.bits, CACHE_MAX_BITS));
+    }
+
+    bool isValid() {return m_isValid;};
+    const PointCacheHeader &header() {return m_header;};
+    int nbFrames() {return m_header.nbFrames;};
+    int nbVertices() {return m_header.nbVertices;};
+    bool isRaw() {return m_header.bits == CACHE_RAW_BITS;};
+
+    bool readFrame(int f, glm::vec3 *positions)
+    {
+        if (!m_isValid || f < 0 || f >= (int) m_header.nbFrames) return false;
+        int keyframe = f - f % m_header.keyframeInterval;
+        int first = (m_lastFrame >= keyframe && m_lastFrame < f) ? m_lastFrame + 1 : keyframe;
+        if (first == keyframe) reset();
+        for (int g = first; g <= f; ++g)
+        {
+            if (!decodeFrame(g, g == f ? positions : nullptr))
+            {
+                m_lastFrame = -1;
+                return false;
+            }
+        }
+        m_lastFrame = f;
+        return true;
+    }
+
+    const glm::vec3 *framePositions(int f)
+    {
+        /**
+         * Positions of a raw frame inside the mapping (nullptr for an encoded frame : use readFrame)
+        */
+        CacheFrameHeader frame;
+        if (!frameHeader(f, frame) || frame.predictor != CACHE_RAW || frame.rawBytes != sizeof(glm::vec3)*m_nbVertices) return nullptr;
+        uint64_t offset = m_offsets[f] + sizeof(CacheFrameHeader);
+        return offset % alignof(glm::vec3) == 0 ? (const glm::vec3 *) (m_file.data() + offset) : nullptr;
+    }
+
+    void prefetch(int f)
+    {
+        if (f < 0 || f >= (int) m_header.nbFrames) return;
+        uint64_t end = f+1 < (int) m_header.nbFrames ? m_offsets[f+1] : m_header.indexOffset;
+        m_file.prefetch(m_offsets[f], end - m_offsets[f]);
+    }
+
+    private:
+    MappedFile m_file;
+    PointCacheHeader m_header;
+    std::vector<uint64_t> m_offsets;
+    bool m_isValid;
+    int m_lastFrame;
+
+    bool frameHeader(int f, CacheFrameHeader &frame)
+    {
+        /**
+         * Copies the header of a frame (encoded frames are not aligned in the file), fails if the frame exceeds the file
+        */
+        if (!m_isValid || f < 0 || f >= (int) m_header.nbFrames || m_offsets[f] + sizeof(CacheFrameHeader) > m_header.indexOffset) return false;
+        memcpy(&frame, m_file.data() + m_offsets[f], sizeof(CacheFrameHeader));
+        return m_offsets[f] + sizeof(CacheFrameHeader) + frame.ransBytes + frame.rawBytes <= m_header.indexOffset;
+    }
+
+    bool decodeFrame(int f, glm::vec3 *positions)
+    {
+        CacheFrameHeader frame;
+        if (!frameHeader(f, frame) || m_nbVertices <= 0) return false;
+        const uint8_t *data = (const uint8_t *) m_file.data() + m_offsets[f] + sizeof(CacheFrameHeader);
+        if (frame.predictor == CACHE_RAW)
+        {
+            if (frame.rawBytes != sizeof(glm::vec3)*m_nbVertices) return false;
+            if (positions) memcpy(positions, data, frame.rawBytes);
+            return true;
+        }
+        if (frame.predictor >= CACHE_NB_PREDICTORS || (int) frame.predictor > m_nbPrevFrames || frame.ransBytes < 4) return false;
+        return decode(frame, data, positions);
+    }
+
+    bool decode(const CacheFrameHeader &frame, const uint8_t *data, glm::vec3 *positions)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            m_models[axis].freqs.assign(frame.freqs[axis], frame.freqs[axis] + CACHE_NB_BUCKETS);
+            uint32_t sum = 0;
+            for (uint16_t freq : m_models[axis].freqs) sum += freq;
+            if (sum != RANS_SCALE) return false;
+            m_models[axis].build();
+        }
+
+        RansDecoder decoder(data, data + frame.ransBytes);
+        const uint8_t *raw = data + frame.ransBytes;
+        const uint8_t *rawEnd = raw + frame.rawBytes;
+        uint64_t bits = 0;
+        int nbBits = 0;
+        for (int k = 0; k < m_nbVertices; ++k)
+        {
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                int bucket = decoder.get(m_models[axis]);
+                uint32_t u = bucket == 0 ? 0 : 1u << (bucket-1);
+                if (bucket > 1)
+                {
+                    for (; nbBits < bucket-1; nbBits += 8) bits |= (uint64_t) (raw < rawEnd ? *raw++ : 0) << nbBits;
+                    u |= bits & ((1u << (bucket-1)) - 1);
+                    bits >>= bucket-1;
+                    nbBits -= bucket-1;
+                }
+                int r = (int) (u >> 1) ^ -(int) (u & 1);
+                m_q[3*k + axis] = predict(frame.predictor, k, axis, frame) + r;
+            }
+        }
+        endFrame(frame, positions);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef RANS_H
+#define RANS_H
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+// Byte-wise range asymmetric numeral system coder (32 bits state, probabilities on RANS_SCALE_BITS bits) with static
+// models : the frequencies of a block are counted first, normalized and stored with it. Symbols are encoded in reverse
+// order so that the decoder reads them forward.
+
+const uint32_t RANS_SCALE_BITS = 12;
+const uint32_t RANS_SCALE = 1u << RANS_SCALE_BITS;
+const uint32_t RANS_L = 1u << 23; // lower bound of the normalized state
+
+struct RansModel
+{
+    /**
+     * Static model of an alphabet (at most 256 symbols) : normalized frequencies (summing to RANS_SCALE, every symbol
+     * that occurs keeps a non-zero frequency), their cumulated starts and the slot -> symbol table of the decoder
+    */
+    std::vector<uint16_t> freqs;
+    std::vector<uint32_t> starts;
+    std::vector<uint8_t> slots;
+
+    void normalize(const std::vector<uint32_t> &counts)
+    {
+        int n = counts.size();
+        uint64_t total = 0;
+        for (uint32_t c : counts) total += c;
+        freqs.assign(n, 0);
+        if (total == 0)
+        {
+            freqs[0] = RANS_SCALE;
+            build();
+            return;
+        }
+
+        uint32_t sum = 0;
+        int largest = 0;
+        for (int s = 0; s < n; ++s)
+        {
+            if (counts[s] == 0) continue;
+            freqs[s] = std::max<uint64_t>(1, (uint64_t) counts[s]*RANS_SCALE/total);
+            sum += freqs[s];
+            if (counts[s] > counts[largest]) largest = s;
+        }
+        // rounding : the excess is taken from the largest frequencies, the deficit goes to the most frequent symbol
+        while (sum > RANS_SCALE)
+        {
+            int s = std::max_element(freqs.begin(), freqs.end()) - freqs.begin();
+            uint32_t excess = std::min<uint32_t>(sum - RANS_SCALE, freqs[s] - 1);
+            freqs[s] -= excess;
+            sum -= excess;
+        }
+        freqs[largest] += RANS_SCALE - sum;
+        build();
+    }
+
+    void build()
+    {
+        int n = freqs.size();
+        starts.assign(n+1, 0);
+        for (int s = 0; s < n; ++s) starts[s+1] = starts[s] + freqs[s];
+        slots.resize(RANS_SCALE);
+        for (int s = 0; s < n; ++s) std::fill(slots.begin() + starts[s], slots.begin() + starts[s+1], (uint8_t) s);
+    }
+};
+
+class RansEncoder
+{
+    public:
+    RansEncoder() : m_state(RANS_L) {}
+
+    void put(const RansModel &model, int symbol)
+    {
+        uint32_t freq = model.freqs[symbol];
+        uint32_t maxState = ((RANS_L >> RANS_SCALE_BITS) << 8)*freq;
+        while (m_state >= maxState)
+        {
+            m_bytes.push_back(m_state & 0xff);
+            m_state >>= 8;
+        }
+        m_state = ((m_state/freq) << RANS_SCALE_BITS) + (m_state%freq) + model.starts[symbol];
+    }
+
+    void finish(std::vector<uint8_t> &out)
+    {
+        /**
+         * Appends the encoded stream to out (final state first, then the bytes in the decoder's reading order)
+        */
+        for (int k = 3; k >= 0; --k) m_bytes.push_back((m_state >> (8*k)) & 0xff);
+        out.insert(out.end(), m_bytes.rbegin(), m_bytes.rend());
+        m_bytes.clear();
+        m_state = RANS_L;
+    }
+
+    private:
+    uint32_t m_state;
+    std::vector<uint8_t> m_bytes; // emitted in reverse order
+};
+
+class RansDecoder
+{
+    public:
+    RansDecoder(const uint8_t *data, const uint8_t *end) : m_ptr(data + 4), m_end(end)
+    {
+        m_state = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t) data[3] << 24);
+    }
+
+    int get(const RansModel &model)
+    {
+        int symbol = model.slots[m_state & (RANS_SCALE - 1)];
+        m_state = model.freqs[symbol]*(m_state >> RANS_SCALE_BITS) + (m_state & (RANS_SCALE - 1)) - model.starts[symbol];
+        while (m_state < RANS_L && m_ptr < m_end) m_state = (m_state << 8) | *m_ptr++;
+        return symbol;
+    }
+
+    private:
+    const uint8_t *m_ptr;
+    const uint8_t *m_end;
+    uint32_t m_state;
+};
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include "glm/gtc/matrix_transform.hpp"
+#include "asset_format.hcu"
+#include "simulation.h"
+
+// Scene description files : one statement per line, '#' starts a comment.
+//   name <scene name>
+//   frames <number of frames to simulate>
+//   cloth <vertices per edge> [transform]
+//   param <SimulationParams field> <value>        e.g. param nbSubSteps 4, param isCCD 1, param wind 1 0 0
+//   collider plane <vertices per edge> [transform] (mesh colliders : BVH, or SDF with 'sdf' instead of 'collider')
+//   collider sphere <radius> [transform]
+//   collider mesh <file.ply|file.obj> [transform]  (loaded from its scene asset when there is one, see asset_format.hcu)
+//   sdf mesh <file.ply|file.obj> [transform]
+//   analytic plane <point xyz> <normal xyz>
+//   analytic sphere <center xyz> <radius>
+//   analytic capsule <a xyz> <b xyz> <radius>
+//   analytic box <center xyz> <half extents xyz>
+// [transform] is a list of translate x y z | rotate degrees ax ay az | scale x y z, multiplied in the order they are
+// written (the last one is applied first, as in main.cu). Relative paths are relative to the scene file.
+
+enum SceneColliderType
+{
+    SCENE_PLANE,
+    SCENE_SPHERE,
+    SCENE_MESH
+};
+
+struct SceneCollider
+{
+    SceneColliderType type;
+    bool isSDF;
+    int resolution; // plane
+    float radius; // sphere
+    std::string path; // mesh
+    glm::mat4 model;
+};
+
+inline bool readValue(std::istringstream &in, float &value) {return (bool) (in >> value);}
+inline bool readValue(std::istringstream &in, int &value) {return (bool) (in >> value);}
+inline bool readValue(std::istringstream &in, bool &value)
+{
+    std::string token;
+    if (!(in >> token)) return false;
+    if (token == "1" || token == "true" || token == "on") value = true;
+    else if (token == "0" || token == "false" || token == "off") value = false;
+    else return false;
+    return true;
+}
+inline bool readValue(std::istringstream &in, glm::vec3 &value) {return (bool) (in >> value.x >> value.y >> value.z);}
+
+inline bool setSceneParam(SimulationParams &params, const std::string &name, std::istringstream &in)
+{
+    #define SCENE_PARAM(field) if (name == #field) return readValue(in, params.field);
+    SCENE_PARAM(timeStep)
+    SCENE_PARAM(nbSubSteps)
+    SCENE_PARAM(isCollisions)
+    SCENE_PARAM(isRotating)
+    SCENE_PARAM(isProfiling)
+    SCENE_PARAM(Ks)
+    SCENE_PARAM(Kd)
+    SCENE_PARAM(unitM)
+    SCENE_PARAM(Ka)
+    SCENE_PARAM(Kf)
+    SCENE_PARAM(contactIterations)
+    SCENE_PARAM(isCompactBVH)
+    SCENE_PARAM(isPacketTraversal)
+    SCENE_PARAM(isTLAS)
+    SCENE_PARAM(isHitCache)
+    SCENE_PARAM(isBroadPhase)
+    SCENE_PARAM(isCCD)
+    SCENE_PARAM(isSelfCollisions)
+    SCENE_PARAM(isCollisionCulling)
+    SCENE_PARAM(collisionInterval)
+    SCENE_PARAM(sdfResolution)
+    SCENE_PARAM(proxyTolerance)
+    SCENE_PARAM(proxyTriangles)
+    #undef SCENE_PARAM
+
+    if (name == "wind")
+    {
+        glm::vec3 wind;
+        if (!readValue(in, wind)) return false;
+        for (int i = 0; i<3; ++i) params.windUI[i] = wind[i];
+        params.updateWind();
+        return true;
+    }
+    return false;
+}
+
+class Scene
+{
+    public:
+    std::string name;
+    int nbFrames;
+    int clothResolution;
+    glm::mat4 clothModel;
+    SimulationParams params;
+    std::vector<SceneCollider> colliders;
+    std::vector<AnalyticShape> shapes;
+
+    Scene() : nbFrames(600), clothResolution(128)
+    {
+        // default cloth of main.cu
+        clothModel = glm::scale(glm::mat4(1.0f), glm::vec3(0.04f, 1.0f, 0.04f));
+        clothModel = glm::translate(clothModel, glm::vec3(0.0f, 2.2f, 0.0f));
+    }
+
+    bool load(const std::string &path, std::string &error)
+    {
+        /**
+         * Parses a scene file (see the format above). Returns false with the first error and its line.
+        */
+        std::ifstream file(path);
+        if (!file)
+        {
+            error = "cannot open " + path;
+            return false;
+        }
+        size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "" : path.substr(0, slash+1);
+        name = path;
+
+        std::string line;
+        int lineNb = 0;
+        while (std::getline(file, line))
+        {
+            ++lineNb;
+            size_t comment = line.find('#');
+            if (comment != std::string::npos) line.erase(comment);
+            std::istringstream in(line);
+            std::string keyword;
+            if (!(in >> keyword)) continue;
+
+            if (!parseStatement(keyword, in, directory, error))
+            {
+                error = path + ":" + std::to_string(lineNb) + " : " + (error.empty() ? "invalid statement '" + keyword + "'" : error);
+                return false;
+            }
+        }
+        params.updateGravity();
+        return true;
+    }
+
+    Simulation *build(GLint clothProgram, GLint colliderProgram, Plane *&cloth, std::vector<Mesh *> &meshes)
+    {
+        /**
+         * Creates the cloth, the simulation and its colliders. Pass HEADLESS_PROGRAM for runs without OpenGL context.
+        */
+        cloth = new Plane(clothProgram, clothModel, clothResolution);
+        Simulation *sim = new Simulation(cloth);
+        for (const AnalyticShape &shape : shapes) sim->addAnalyticCollider(shape);
+        for (SceneCollider &collider : colliders)
+        {
+            if (collider.type == SCENE_MESH)
+            {
+                MeshFromAsset *mesh = new MeshFromAsset(colliderProgram, collider.model, collider.path.c_str());
+                meshes.push_back(mesh);
+                if (collider.isSDF) sim->addSDFCollider(mesh, params.sdfResolution);
+                else sim->addCollider(mesh, nullptr, params.proxyTolerance, params.proxyTriangles);
+                continue;
+            }
+
+            Mesh *mesh;
+            if (collider.type == SCENE_PLANE) mesh = new Plane(colliderProgram, collider.model, collider.resolution);
+            else mesh = new Sphere(colliderProgram, collider.model, collider.radius);
+            meshes.push_back(mesh);
+            if (collider.isSDF) sim->addSDFCollider(mesh, params.sdfResolution);
+            else sim->addCollider(mesh, nullptr, params.proxyTolerance, params.proxyTriangles);
+        }
+        return sim;
+    }
+
+    private:
+    static bool parseTransform(std::istringstream &in, glm::mat4 &model)
+    {
+        model = glm::mat4(1.0f);
+        std::string op;
+        while (in >> op)
+        {
+            glm::vec3 v;
+            if (op == "translate" && readValue(in, v)) model = model*glm::translate(glm::mat4(1.0f), v);
+            else if (op == "scale" && readValue(in, v)) model = model*glm::scale(glm::mat4(1.0f), v);
+            else if (op == "rotate")
+            {
+                float degrees;
+                if (!readValue(in, degrees) || !readValue(in, v)) return false;
+                model = model*glm::rotate(glm::mat4(1.0f), glm::radians(degrees), v);
+            }
+            else return false;
+        }
+        return true;
+    }
+
+    bool parseStatement(const std::string &keyword, std::istringstream &in, const std::string &directory, std::string &error)
+    {
+        error.clear();
+        if (keyword == "name") return (bool) std::getline(in >> std::ws, name);
+        if (keyword == "frames") return readValue(in, nbFrames) && nbFrames > 0;
+        if (keyword == "cloth")
+        {
+            if (!readValue(in, clothResolution) || clothResolution < 2) return false;
+            in >> std::ws;
+            return in.eof() || parseTransform(in, clothModel); // (default transform of main.cu if none is given)
+        }
+        if (keyword == "param")
+        {
+            std::string field;
+            if (!(in >> field)) return false;
+            if (!setSceneParam(params, field, in)) error = "unknown parameter or invalid value for '" + field + "'";
+            return error.empty();
+        }
+
+        if (keyword == "collider" || keyword == "sdf")
+        {
+            SceneCollider collider {SCENE_PLANE, keyword == "sdf", 0, 0.0f, "", glm::mat4(1.0f)};
+            std::string type;
+            if (!(in >> type)) return false;
+            bool isValid;
+            if (type == "plane") isValid = readValue(in, collider.resolution) && collider.resolution > 1;
+            else if (type == "sphere")
+            {
+                collider.type = SCENE_SPHERE;
+                isValid = readValue(in, collider.radius) && collider.radius > 0.0f;
+            }
+            else if (type == "mesh")
+            {
+                collider.type = SCENE_MESH;
+                isValid = (bool) (in >> collider.path);
+                if (isValid && collider.path[0] != '/') collider.path = directory + collider.path;
+            }
+            else
+            {
+                error = "unknown collider type '" + type + "'";
+                return false;
+            }
+            if (!isValid || !parseTransform(in, collider.model)) return false;
+            colliders.push_back(collider);
+            return true;
+        }
+
+        if (keyword == "analytic")
+        {
+            std::string type;
+            glm::vec3 a, b;
+            float radius;
+            if (!(in >> type)) return false;
+            if (type == "plane" && readValue(in, a) && readValue(in, b)) shapes.push_back(AnalyticShape::plane(a, b));
+            else if (type == "sphere" && readValue(in, a) && readValue(in, radius)) shapes.push_back(AnalyticShape::sphere(a, radius));
+            else if (type == "capsule" && readValue(in, a) && readValue(in, b) && readValue(in, radius))
+                shapes.push_back(AnalyticShape::capsule(a, b, radius));
+            else if (type == "box" && readValue(in, a) && readValue(in, b)) shapes.push_back(AnalyticShape::box(a, b));
+            else return false;
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
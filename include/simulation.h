@@ -5,6 +5,21 @@
 #include "mesh.hcu"
 #include "explicit_solver.hcu"
 #include "collisions_solver.hcu"
+#include "asset_format.hcu"
+#include "checkpoint.hcu"
+#include "frame_export.hcu"
+#include "point_cache.h"
+#include "vertex_cache.h"
+#include "mesh_sequence.h"
+
+struct SimulationState
+{
+    // checkpoint header of the simulation : the cloth it was taken on and the frame to resume from
+    int nbVertices;
+    int N;
+    int iFrame;
+    int padding;
+};
 
 enum SOLVER_TYPE
 {
@@ -21,6 +36,12 @@ class Simulation
     ExplicitSolver *m_solver;
     CollisionSolver *m_collisionSolver;
 
+    // export of the cloth frames (writer thread), see startExport
+    FrameExporter *m_exporter;
+    PointCacheWriter *m_cacheWriter;
+    VertexCacheWriter *m_vertexCacheWriter;
+    MeshSequenceWriter *m_meshWriter;
+
 
     
 
@@ -28,7 +49,7 @@ class Simulation
 
     public:
     Simulation(Plane *grid)
-    : m_grid(grid), m_iFrame(0)
+    : m_grid(grid), m_exporter(nullptr), m_cacheWriter(nullptr), m_vertexCacheWriter(nullptr), m_meshWriter(nullptr), m_iFrame(0)
     {
         m_grid->bindCudaData();
         m_solver = new ExplicitSolver(grid);
@@ -38,6 +59,7 @@ class Simulation
 
     ~Simulation()
     {
+        stopExport();
         delete m_solver;
         delete m_collisionSolver;
 
@@ -51,21 +73,161 @@ class Simulation
         m_collisionSolver->bindCollidersCudaData();
         for (int i=0; i<params.nbSubSteps; i++) 
         {
-            m_solver->step(m_grid, params, m_collisionSolver->collisionsFBuffer());
-            if (params.isCollisions) m_collisionSolver->solve(m_grid, m_solver->getVelocities(), params, m_solver->getFBuffer());
+            if (params.isCCD && params.isCollisions) m_collisionSolver->storeClothPositions(m_grid);
+            m_solver->step(m_grid, params);
+            if (params.isCollisions) m_collisionSolver->solve(m_grid, m_solver->getVelocities(), params);
+            else m_collisionSolver->invalidateClearance();
         }
         m_collisionSolver->unBindCollidersCudaData();
+        // (frames out of a vertex cache's range are not copied, nor counted as written by the exporter)
+        bool isExported = m_exporter && (!m_vertexCacheWriter || m_vertexCacheWriter->isInRange(m_iFrame));
+        if (isExported) m_exporter->snapshot((glm::vec3 *) m_grid->getDataPtr(0), m_iFrame, (glm::vec3 *) m_grid->getDataPtr(1));
         m_grid->unbindCudaData();
         m_iFrame++;
     }
 
+    void startExport(const std::string &path, float frameTime, int bits = 16, int nbSlots = 4)
+    {
+        /**
+         * Streams the cloth frames to a compressed point cache, written by a background thread (see FrameExporter)
+        */
+        stopExport();
+        m_cacheWriter = new PointCacheWriter(path, m_grid->getVerticesNb(), m_grid->N(), bits, 30, frameTime);
+        PointCacheWriter *writer = m_cacheWriter;
+        m_exporter = new FrameExporter(m_grid->getVerticesNb(), [writer](int frame, const glm::vec3 *positions, int nbVertices)
+        {
+            return writer->writeFrame(positions);
+        }, nbSlots);
+    }
+
+    void startExport(const std::string &path, VertexCacheFormat format, float frameRate = 60.0f, int firstFrame = 0, int lastFrame = -1,
+        int nbSlots = 4)
+    {
+        /**
+         * Same for the PC2 / MDD vertex caches of the DCC tools (frame range in simulation frames, see VertexCacheWriter)
+        */
+        stopExport();
+        m_vertexCacheWriter = new VertexCacheWriter(path, format, m_grid->getVerticesNb(), frameRate, firstFrame, lastFrame);
+        VertexCacheWriter *writer = m_vertexCacheWriter;
+        m_exporter = new FrameExporter(m_grid->getVerticesNb(), [writer](int frame, const glm::vec3 *positions, int nbVertices)
+        {
+            return writer->writeFrame(frame, positions);
+        }, nbSlots);
+    }
+
+    void startExport(const std::string &prefix, MeshSequenceFormat format, int nbSlots = 4)
+    {
+        /**
+         * Same for a PLY / OBJ mesh per frame (<prefix>_<frame>, see MeshSequenceWriter) : the exporter copies the normals too
+        */
+        stopExport();
+        m_meshWriter = new MeshSequenceWriter(prefix, format, m_grid->getVerticesNb(), m_grid->getIndices());
+        MeshSequenceWriter *writer = m_meshWriter;
+        m_exporter = new FrameExporter(m_grid->getVerticesNb(), [writer](int frame, const glm::vec3 *positions, int nbVertices)
+        {
+            return writer->writeFrame(frame, positions, positions + nbVertices);
+        }, nbSlots, true);
+    }
+
+    void startExport(const FrameSink &sink, int nbSlots = 4)
+    {
+        stopExport();
+        m_exporter = new FrameExporter(m_grid->getVerticesNb(), sink, nbSlots);
+    }
+
+    void stopExport()
+    {
+        // (the exporter writes its pending frames before the cache is closed)
+        delete m_exporter;
+        m_exporter = nullptr;
+        delete m_cacheWriter;
+        m_cacheWriter = nullptr;
+        delete m_vertexCacheWriter;
+        m_vertexCacheWriter = nullptr;
+        delete m_meshWriter;
+        m_meshWriter = nullptr;
+    }
+
+    bool saveCheckpoint(const std::string &path)
+    {
+        /**
+         * Writes the whole dynamic state (see checkpoint.hcu) : a run restored from it goes on as if uninterrupted
+        */
+        CheckpointWriter checkpoint(path);
+        if (!checkpoint.isOpen()) return false;
+        checkpoint.put(CKPT_SIMULATION, 0, SimulationState {m_grid->getVerticesNb(), m_grid->N(), m_iFrame, 0});
+
+        m_grid->bindCudaData();
+        m_collisionSolver->bindCollidersCudaData();
+        size_t size = sizeof(glm::vec3)*m_grid->getVerticesNb();
+        checkpoint.putDevice(CKPT_CLOTH_POSITIONS, 0, m_grid->getDataPtr(0), size);
+        checkpoint.putDevice(CKPT_CLOTH_NORMALS, 0, m_grid->getDataPtr(1), size);
+        m_solver->saveState(m_grid, checkpoint);
+        m_collisionSolver->saveState(checkpoint);
+        m_collisionSolver->unBindCollidersCudaData();
+        m_grid->unbindCudaData();
+        return checkpoint.close();
+    }
+
+    CheckpointRestore restoreCheckpoint(const std::string &path)
+    {
+        /**
+         * The checkpoint must come from the same scene (cloth resolution, colliders and their BVHs) : every section is
+         * checked against the live buffers before anything is copied, a mismatched checkpoint changes nothing.
+        */
+        CheckpointReader checkpoint(path);
+        if (!checkpoint.isValid()) return CHECKPOINT_MISSING;
+
+        SimulationState state;
+        size_t size = sizeof(glm::vec3)*m_grid->getVerticesNb();
+        bool isMatching = checkpoint.get(CKPT_SIMULATION, 0, state) && state.nbVertices == m_grid->getVerticesNb() && state.N == m_grid->N()
+            && checkpoint.matches(CKPT_CLOTH_POSITIONS, 0, size)
+            && checkpoint.matches(CKPT_CLOTH_NORMALS, 0, size)
+            && m_solver->matchesState(m_grid, checkpoint)
+            && m_collisionSolver->matchesState(checkpoint);
+        if (!isMatching) return CHECKPOINT_MISMATCHED;
+
+        m_grid->bindCudaData();
+        m_collisionSolver->bindCollidersCudaData();
+        checkpoint.getDevice(CKPT_CLOTH_POSITIONS, 0, m_grid->getDataPtr(0), size);
+        checkpoint.getDevice(CKPT_CLOTH_NORMALS, 0, m_grid->getDataPtr(1), size);
+        m_solver->restoreState(m_grid, checkpoint);
+        m_collisionSolver->restoreState(checkpoint);
+        m_collisionSolver->unBindCollidersCudaData();
+        m_grid->unbindCudaData();
+        m_iFrame = state.iFrame;
+        return CHECKPOINT_RESTORED;
+    }
+
+    int frame() {return m_iFrame;};
+
+    FrameExporter *exporter() {return m_exporter;};
+    PointCacheWriter *cacheWriter() {return m_cacheWriter;};
+    VertexCacheWriter *vertexCacheWriter() {return m_vertexCacheWriter;};
+    MeshSequenceWriter *meshWriter() {return m_meshWriter;};
+
     ExplicitSolver *solver() {return m_solver;};
 
     CollisionSolver *collisionSolver() {return m_collisionSolver;};
 
-     void addCollider(Mesh *collider, glm::vec3 *velPtr=nullptr)
+     void addCollider(Mesh *collider, glm::vec3 *velPtr=nullptr, float proxyTolerance=PROXY_TOLERANCE, int proxyTriangles=0)
+    {
+        m_collisionSolver->addCollider(collider, velPtr, proxyTolerance, proxyTriangles);
+    };
+
+    void addCollider(MeshFromAsset *collider, glm::vec3 *velPtr=nullptr, float proxyTolerance=PROXY_TOLERANCE, int proxyTriangles=0)
+    {
+        m_collisionSolver->addCollider(collider, velPtr, proxyTolerance, proxyTriangles);
+    };
+
+    void addAnalyticCollider(const AnalyticShape &shape)
+    {
+        m_collisionSolver->addAnalyticCollider(shape);
+    };
+
+    void addSDFCollider(Mesh *collider, int resolution)
     {
-        m_collisionSolver->addCollider(collider, velPtr);
+        m_collisionSolver->addSDFCollider(collider, resolution);
     };
 
     void reset()
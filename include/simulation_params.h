@@ -13,6 +13,7 @@ struct SimulationParams
     bool isPaused;
     bool isCollisions;
     bool isRotating;
+    bool isProfiling;
 
     // camera params
     float cameraSpeed;
@@ -30,6 +31,19 @@ struct SimulationParams
 
     // collision params
     float Kf;
+    int contactIterations; // maximum number of iterations of the contact solver
+    bool isCompactBVH;
+    bool isPacketTraversal;
+    bool isTLAS; // single detection pass through a top-level tree over the mesh colliders
+    bool isHitCache;
+    bool isBroadPhase;
+    bool isCCD;
+    bool isSelfCollisions;
+    bool isCollisionCulling; // discrete detection skipped for the vertices that cannot have reached a collider
+    int collisionInterval; // discrete detection every collisionInterval substeps
+    int sdfResolution; // voxels along the largest side of the SDF colliders
+    float proxyTolerance; // error bound of the rigid colliders' collision proxies, in cloth thicknesses (0 : full meshes)
+    int proxyTriangles; // triangle count the proxies are decimated down to (0 : only bounded by the tolerance)
 
     // UI callbacks
     void updateWind()
@@ -60,12 +74,58 @@ struct SimulationParams
         isCollisions = !isCollisions;
     };
 
+    void changeProfiling() 
+    { 
+        isProfiling = !isProfiling;
+    };
+
+    void changeCompactBVH() 
+    { 
+        isCompactBVH = !isCompactBVH;
+    };
+
+    void changePacketTraversal() 
+    { 
+        isPacketTraversal = !isPacketTraversal;
+    };
+
+    void changeTLAS() 
+    { 
+        isTLAS = !isTLAS;
+    };
+
+    void changeHitCache() 
+    { 
+        isHitCache = !isHitCache;
+    };
+
+    void changeCCD() 
+    { 
+        isCCD = !isCCD;
+    };
+
+    void changeSelfCollisions() 
+    { 
+        isSelfCollisions = !isSelfCollisions;
+    };
+
+    void changeCollisionCulling() 
+    { 
+        isCollisionCulling = !isCollisionCulling;
+    };
+
+    void changeBroadPhase() 
+    { 
+        isBroadPhase = !isBroadPhase;
+    };
+
     SimulationParams() : 
     timeStep(0.0025f),
     nbSubSteps(1), 
     isPaused(false),
     isCollisions(true),
     isRotating(false),
+    isProfiling(false),
     Ks(400.0f), 
     Kd(10.0f), 
     Ka(0.1f), 
@@ -74,6 +134,19 @@ struct SimulationParams
     windUI({0.0f, 0.0f, 0.0f}),
     gravity(glm::vec3(0.0f, -9.81f*unitM, 0.0f)),
     Kf(0.4),
+    contactIterations(8),
+    isCompactBVH(true),
+    isPacketTraversal(false),
+    isTLAS(true),
+    isHitCache(true),
+    isBroadPhase(true),
+    isCCD(false),
+    isSelfCollisions(false),
+    isCollisionCulling(true),
+    collisionInterval(1),
+    sdfResolution(64),
+    proxyTolerance(0.5f),
+    proxyTriangles(0),
     cameraSpeed(10.0f),
     cameraSensitivity(0.10f)
     { }
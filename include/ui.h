@@ -85,6 +85,87 @@ class GUI
             simParams->changePaused();
         }
 
+        if (ImGui::Button("SAVE CHECKPOINT", ImVec2(150, 30))) 
+        {
+            m_checkpointStatus = sim->saveCheckpoint("cloth.ckpt") ? "saved to cloth.ckpt" : "cannot write cloth.ckpt";
+        }
+        if (ImGui::Button("LOAD CHECKPOINT", ImVec2(150, 30))) 
+        {
+            CheckpointRestore restore = sim->restoreCheckpoint("cloth.ckpt");
+            if (restore == CHECKPOINT_RESTORED) m_checkpointStatus = "loaded cloth.ckpt";
+            else if (restore == CHECKPOINT_MISSING) m_checkpointStatus = "cloth.ckpt is missing (or not a checkpoint)";
+            else m_checkpointStatus = "cloth.ckpt does not match the scene";
+        }
+        if (!m_checkpointStatus.empty()) ImGui::Text("Checkpoint : %s (frame %i)", m_checkpointStatus.c_str(), sim->frame());
+
+        if (ImGui::Button("COLLISION PROFILING", ImVec2(150, 30))) 
+        {
+            simParams->changeProfiling();
+        }
+
+        if (sim->exporter())
+        {
+            if (ImGui::Button("STOP EXPORT", ImVec2(150, 30))) sim->stopExport();
+        }
+        else
+        {
+            if (ImGui::Button("EXPORT CACHE", ImVec2(150, 30))) sim->startExport("cloth.pcache", simParams->timeStep*simParams->nbSubSteps);
+            if (ImGui::Button("EXPORT PC2", ImVec2(150, 30))) sim->startExport("cloth.pc2", VERTEX_CACHE_PC2, 60.0f, sim->frame());
+            if (ImGui::Button("EXPORT PLY", ImVec2(150, 30))) sim->startExport("cloth", MESH_SEQUENCE_PLY);
+        }
+
+        if (FrameExporter *exporter = sim->exporter())
+        {
+            ImGui::Text("Export : %i frames written to %s (%i failed), %i / %i slots pending", exporter->nbWritten(),
+                sim->cacheWriter() ? "cloth.pcache" : (sim->meshWriter() ? "cloth_*.ply" : "cloth.pc2"), exporter->nbFailed(), exporter->nbPending(), exporter->nbSlots());
+            ImGui::Text("Writer : %.1f ms per frame, simulation stalled %.1f ms", 
+                exporter->writeTime()*1000.0/std::max(exporter->nbWritten() + exporter->nbFailed(), 1), exporter->stallTime()*1000.0);
+            if (PointCacheWriter *cache = sim->cacheWriter()) ImGui::Text("Point cache : %.1f MB -> %.2f MB", cache->rawBytes()*1e-6, 
+                cache->encodedBytes()*1e-6);
+        }
+
+        if (simParams->isProfiling)
+        {
+            ImGui::SeparatorText("COLLISION STATS");
+            const CollisionStats &stats = collisionSolver->stats();
+            float queries = stats.queries > 0 ? (float) stats.queries : 1.0f;
+            ImGui::Text("BVH layout : %s", simParams->isCompactBVH ? "compact" : "binary");
+            ImGui::Text("Traversal : %s", (simParams->isCompactBVH && simParams->isPacketTraversal) ? "packets" : "single rays");
+            ImGui::Text("Queries per substep : %llu", stats.queries);
+            ImGui::Text("Contacts per substep : %llu (%llu dropped)", stats.contacts, stats.contactsOverflow);
+            if (stats.queriesTotal > 0) ImGui::Text("Culling : %.1f%% of the vertex queries skipped, detection on %llu / %llu substeps", 
+                100.0f*stats.queriesCulled/(float) stats.queriesTotal, stats.substepsDetected, stats.substeps);
+            if (stats.contactVertices > 0) ImGui::Text("Contact solver : %.2f iterations (max %llu), %llu / %llu converged, %llu warm-started", 
+                stats.contactIterations/(float) stats.contactVertices, stats.contactIterationsMax, 
+                stats.contactVerticesConverged, stats.contactVertices, stats.contactsWarmStarted);
+            ImGui::Text("Broad phase : %llu / %llu tiles dispatched, %llu colliders culled", 
+                stats.tilesDispatched, stats.tilesTotal, stats.collidersCulled);
+            ImGui::Text("Detection time : %.3f ms (%.2f Mqueries/s)", collisionSolver->detectionTime(), 
+                stats.queries/(collisionSolver->detectionTime()*1000.0f + 1e-6f));
+            ImGui::Text("Traversal steps per query : %.2f", stats.nodesVisited/queries);
+            if (stats.instancesVisited > 0) ImGui::Text("Instances visited per query : %.2f", stats.instancesVisited/queries);
+            if (stats.packets > 0) ImGui::Text("Diverged packets : %llu / %llu", stats.packetsDiverged, stats.packets);
+            if (stats.cacheLookups > 0)
+            {
+                float lookups = (float) stats.cacheLookups;
+                ImGui::Text("Hit cache : %.1f%% of the lookups skip the traversal (triangle %.1f%%, leaf %.1f%%, local %.1f%%)", 
+                    100.0f*(stats.cacheTriangleHits + stats.cacheLeafHits + stats.cacheLocalHits)/lookups,
+                    100.0f*stats.cacheTriangleHits/lookups, 100.0f*stats.cacheLeafHits/lookups, 100.0f*stats.cacheLocalHits/lookups);
+            }
+            ImGui::Text("Triangles tested per query : %.2f", stats.trianglesTested/queries);
+            ImGui::Text("Bytes touched per query : %.1f", stats.bytesTouched/queries);
+            ImGui::Text("Colliders memory : %.1f kB on the device, %.1f kB read by the traversal", collisionSolver->collidersMemory()/1000.0f,
+                collisionSolver->traversalMemory(simParams->isCompactBVH)/1000.0f);
+            glm::ivec2 colliderTris = collisionSolver->colliderTriangles();
+            if (colliderTris.x < colliderTris.y) ImGui::Text("Collision proxies : %i / %i triangles (error %.4f), built in %.1f ms", 
+                colliderTris.x, colliderTris.y, collisionSolver->proxyError(), collisionSolver->proxyBuildTime()*1000.0);
+            if (simParams->isCCD) ImGui::Text("Continuous detection : %llu candidate pairs (%llu dropped), %llu impacts", 
+                stats.ccdPairs, stats.ccdOverflow, stats.ccdHits);
+            if (simParams->isSelfCollisions) ImGui::Text("Self collisions : %llu proximities", stats.selfContacts);
+            if (collisionSolver->nbSDFColliders() > 0) ImGui::Text("SDF colliders : %.1f kB, built in %.1f ms", 
+                collisionSolver->sdfMemory()/1000.0f, collisionSolver->sdfBuildTime()*1000.0);
+        }
+
         ImGui::End();
 
         ImGui::Begin("SETTINGS WINDOW");
@@ -137,10 +218,85 @@ class GUI
         
         ImGui::SeparatorText("COLLISION PARAMETERS");
         ImGui::SliderFloat("Friction coefficient", &simParams->Kf, 0.0f, 50.0f, "%.2f");
+        ImGui::SliderInt("Contact iterations", &simParams->contactIterations, 1, 32);
+        if (ImGui::Button("COMPACT BVH", ImVec2(150, 30))) 
+        {
+            simParams->changeCompactBVH();
+        }
+        if (ImGui::Button("PACKET TRAVERSAL", ImVec2(150, 30))) 
+        {
+            simParams->changePacketTraversal();
+        }
+        if (ImGui::Button("TWO-LEVEL BVH", ImVec2(150, 30))) 
+        {
+            simParams->changeTLAS();
+        }
+        if (ImGui::Button("HIT CACHE", ImVec2(150, 30))) 
+        {
+            simParams->changeHitCache();
+        }
+        if (ImGui::Button("BROAD PHASE", ImVec2(150, 30))) 
+        {
+            simParams->changeBroadPhase();
+        }
+        if (ImGui::Button("COLLISION CULLING", ImVec2(150, 30))) 
+        {
+            simParams->changeCollisionCulling();
+        }
+        ImGui::SliderInt("Collision interval", &simParams->collisionInterval, 1, 8);
+        if (ImGui::Button("CONTINUOUS COLLISIONS", ImVec2(150, 30))) 
+        {
+            simParams->changeCCD();
+        }
+        if (ImGui::Button("SELF COLLISIONS", ImVec2(150, 30))) 
+        {
+            simParams->changeSelfCollisions();
+        }
+        ImGui::SliderInt("SDF resolution", &simParams->sdfResolution, 16, 256);
+        if (ImGui::Button("REBUILD SDF", ImVec2(150, 30))) 
+        {
+            collisionSolver->rebuildSDFColliders(simParams->sdfResolution);
+        }
+        ImGui::SliderFloat("Proxy tolerance", &simParams->proxyTolerance, 0.0f, 1.0f);
+        ImGui::SliderInt("Proxy triangles", &simParams->proxyTriangles, 0, 20000);
+        if (ImGui::Button("REBUILD PROXIES", ImVec2(150, 30))) 
+        {
+            collisionSolver->rebuildColliderProxies(simParams->proxyTolerance, simParams->proxyTriangles);
+        }
 
 
         
         
+        ImGui::End();
+    }
+
+    void buildPlaybackWindow(CachePlayback *playback, SimulationParams *simParams, Plane *cloth)
+    {
+        ImGui::Begin("PLAYBACK WINDOW");
+
+        float currFrameRate = ImGui::GetIO().Framerate;
+        ImGui::Text("Average %.3f ms/frame (%.1f FPS)", 1000.0f / currFrameRate, currFrameRate);
+        ImGui::Text("Point cache : %i frames of %i vertices (%s)", playback->nbFrames(), cloth->getVerticesNb(), 
+            playback->isRaw() ? "raw" : "encoded");
+        ImGui::Text("Frame upload : %.3f ms", playback->uploadTime());
+
+        if (ImGui::Button(playback->isPlaying() ? "PAUSE PLAYBACK" : "RESUME PLAYBACK", ImVec2(150, 30))) 
+        {
+            playback->changePlaying();
+        }
+
+        int frame = playback->frame();
+        if (ImGui::SliderInt("Frame", &frame, 0, playback->nbFrames()-1)) playback->seek(cloth, frame);
+
+        if (ImGui::Button("CLOTH WIREFRAME", ImVec2(150, 30))) 
+        {
+            clothWireframe = !clothWireframe;
+        }
+
+        ImGui::SeparatorText("CAMERA PARAMETERS");
+        ImGui::SliderFloat("Camera Speed (trans)", &simParams->cameraSpeed, 0.0f, 100.0f, "%.1f");
+        ImGui::SliderFloat("Camera Sensitivity (rot)", &simParams->cameraSensitivity, 0.0f, 100.0f, "%.1f");
+
         ImGui::End();
     }
 
@@ -152,6 +308,7 @@ class GUI
 
 
     private:
+    std::string m_checkpointStatus;
     std::vector<float> m_framerates;
     std::vector<float> m_frameIDs;
     int currFrameId;
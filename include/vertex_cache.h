@@ -0,0 +1,175 @@
+#ifndef VERTEX_CACHE_H
+#define VERTEX_CACHE_H
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+
+// Vertex caches read by DCC tools (Blender's and Maya's point cache importers) : uncompressed positions, appended
+// frame after frame as the simulation produces them.
+// PC2 : little endian, 32 bytes header ("POINTCACHE2", version, points, start frame, sampling, samples) then the
+//       samples. The number of samples is fixed up in the header when the file is closed.
+// MDD : big endian, frame count, point count, the time of each frame (in s), then the frames. The times come before
+//       the data : the frame range must be bounded, frames missing at close repeat the last one written.
+// Positions are written as simulated (y up) : the importers convert the axes.
+
+enum VertexCacheFormat
+{
+    VERTEX_CACHE_PC2,
+    VERTEX_CACHE_MDD
+};
+
+struct PC2Header
+{
+    char magic[12];
+    int32_t version;
+    int32_t nbPoints;
+    float startFrame;
+    float sampling; // frames between two samples
+    int32_t nbSamples;
+};
+
+inline uint32_t swapBytes(uint32_t v)
+{
+    return __builtin_bswap32(v);
+}
+
+class VertexCacheWriter
+{
+    public:
+    VertexCacheWriter(const std::string &path, VertexCacheFormat format, int nbVertices, float frameRate = 60.0f, int firstFrame = 0,
+        int lastFrame = -1)
+    : m_format(format),
+    m_file(nullptr),
+    m_nbVertices(nbVertices),
+    m_frameRate(frameRate),
+    m_firstFrame(firstFrame),
+    m_lastFrame(lastFrame),
+    m_nbFrames(0),
+    m_bytes(0)
+    {
+        /**
+         * Frames are given with their index : the ones outside [firstFrame, lastFrame] are skipped (lastFrame < 0 : no end,
+         * PC2 only)
+        */
+        if (format == VERTEX_CACHE_MDD && lastFrame < firstFrame) return;
+        m_file = fopen(path.c_str(), "wb");
+        if (m_file && !writeHeader()) closeFile();
+    }
+
+    ~VertexCacheWriter()
+    {
+        close();
+    }
+
+    bool isOpen() {return m_file != nullptr;};
+    int nbFrames() {return m_nbFrames;};
+    size_t bytes() {return m_bytes;};
+
+    bool isInRange(int frame) {return frame >= m_firstFrame && (m_lastFrame < 0 || frame <= m_lastFrame);};
+
+    bool writeFrame(int frame, const glm::vec3 *positions)
+    {
+        /**
+         * Frames in the range are expected in order and without gaps (a frame written again or out of order fails).
+         * Frames out of the range are skipped and not counted : callers that count their writes check isInRange first.
+        */
+        if (!m_file) return false;
+        if (!isInRange(frame)) return true;
+        if (frame != m_firstFrame + m_nbFrames) return false;
+
+        const void *data = positions;
+        if (m_format == VERTEX_CACHE_MDD)
+        {
+            m_swapped.resize(3*m_nbVertices);
+            const uint32_t *words = (const uint32_t *) positions;
+            for (int k = 0; k < 3*m_nbVertices; ++k) m_swapped[k] = swapBytes(words[k]);
+            data = m_swapped.data();
+        }
+        if (fwrite(data, sizeof(glm::vec3), m_nbVertices, m_file) != (size_t) m_nbVertices)
+        {
+            closeFile();
+            return false;
+        }
+        m_nbFrames++;
+        m_bytes += sizeof(glm::vec3)*m_nbVertices;
+        return true;
+    }
+
+    bool close()
+    {
+        /**
+         * Completes the file : number of samples of a PC2 file, missing frames of a MDD file
+        */
+        if (!m_file) return false;
+        bool isValid = true;
+        if (m_format == VERTEX_CACHE_PC2)
+        {
+            int32_t nbSamples = m_nbFrames;
+            isValid = fseek(m_file, offsetof(PC2Header, nbSamples), SEEK_SET) == 0 && fwrite(&nbSamples, sizeof(int32_t), 1, m_file) == 1;
+        }
+        else
+        {
+            int nbMissing = m_lastFrame - m_firstFrame + 1 - m_nbFrames;
+            if (m_nbFrames == 0) m_swapped.assign(3*m_nbVertices, 0); // (nothing simulated in the range : origin)
+            for (int f = 0; f < nbMissing && isValid; ++f)
+            {
+                isValid = fwrite(m_swapped.data(), sizeof(glm::vec3), m_nbVertices, m_file) == (size_t) m_nbVertices;
+            }
+        }
+        isValid = (fclose(m_file) == 0) && isValid;
+        m_file = nullptr;
+        return isValid;
+    }
+
+    private:
+    VertexCacheFormat m_format;
+    FILE *m_file;
+    int m_nbVertices;
+    float m_frameRate;
+    int m_firstFrame;
+    int m_lastFrame;
+    int m_nbFrames;
+    size_t m_bytes;
+    std::vector<uint32_t> m_swapped; // big endian frame (MDD)
+
+    void closeFile()
+    {
+        fclose(m_file);
+        m_file = nullptr;
+    }
+
+    bool writeHeader()
+    {
+        if (m_format == VERTEX_CACHE_PC2)
+        {
+            PC2Header header;
+            memset(&header, 0, sizeof(PC2Header));
+            memcpy(header.magic, "POINTCACHE2", 12);
+            header.version = 1;
+            header.nbPoints = m_nbVertices;
+            header.startFrame = m_firstFrame;
+            header.sampling = 1.0f;
+            return fwrite(&header, sizeof(PC2Header), 1, m_file) == 1;
+        }
+
+        int nbFrames = m_lastFrame - m_firstFrame + 1;
+        std::vector<uint32_t> header(2 + nbFrames);
+        header[0] = swapBytes(nbFrames);
+        header[1] = swapBytes(m_nbVertices);
+        for (int f = 0; f < nbFrames; ++f)
+        {
+            float time = (m_firstFrame + f)/m_frameRate;
+            uint32_t word;
+            memcpy(&word, &time, sizeof(float));
+            header[2 + f] = swapBytes(word);
+        }
+        return fwrite(header.data(), sizeof(uint32_t), header.size(), m_file) == header.size();
+    }
+};
+
+#endif
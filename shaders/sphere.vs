@@ -16,9 +16,9 @@ out vec3 p_color;
 
 void main()
 {
-    p_normal = n;
+    p_normal = mat3(model)*n;
     p_uv = uv;
-    p_pos = pos;
+    p_pos = vec3(model*vec4(pos, 1.0));
     p_color = color;
     gl_Position = projection*view*model*vec4(pos, 1.0);
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "glad.h"
 #include "../include/mesh.hcu"
+#include "../include/asset_format.hcu"
 #include "../include/camera.h"
 #include "../include/simulation.h"
+#include "../include/cache_playback.hcu"
 #include "../include/ui.h"
 #include <iostream>
 
@@ -26,8 +28,22 @@ float dt = 0.0f;	// time between current frame and last frame
 float lastFrame = 0.0f;
 
 
-int main()
+int main(int argc, char **argv)
 {
+    // usage : cloth_sim [-m] [-s] [cache.pcache]
+    // -m : the ground and the sphere collide through their meshes (BVHs, rigid motion, proxies) instead of as analytic shapes,
+    // -s : adds the teapot, on the ground under the cloth, as a signed distance field collider,
+    // cache.pcache : plays a cached run back instead of simulating it
+    bool isAnalyticScene = true;
+    bool isSDFScene = false;
+    const char *cachePath = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "-m") isAnalyticScene = false;
+        else if (std::string(argv[i]) == "-s") isSDFScene = true;
+        else cachePath = argv[i];
+    }
+
     // initializing OpenGL context using GLFW & GLAD
     if (!glfwInit())
     {
@@ -70,14 +86,26 @@ int main()
 
 
     // setting simulation objects (drawables)
+    auto sceneStart = std::chrono::steady_clock::now();
     ShaderProgram ground_pgrm("../shaders/ground.vs", "../shaders/ground.fs");
     ShaderProgram simple_pgrm("../shaders/sphere.vs", "../shaders/sphere.fs");
     ShaderProgram cloth_pgrm("../shaders/cloth.vs", "../shaders/cloth.fs");
 
 
+    CachePlayback *playback = nullptr;
+    if (cachePath)
+    {
+        playback = new CachePlayback(cachePath);
+        if (!playback->isValid())
+        {
+            std::cout << "Cannot play " << cachePath << " (not a cloth point cache)" << std::endl;
+            return -1;
+        }
+    }
+
     glm::mat4x4 modelCloth = glm::scale(glm::mat4(1.0f), glm::vec3(0.04f, 1.0f, 0.04f));
     modelCloth = glm::translate(modelCloth, glm::vec3(0.0f, 2.2f, 0.0f));
-    Plane *cloth = new Plane(cloth_pgrm.glid, modelCloth, 128); // N = 128 OK -> put scale to 0.04f if N=128
+    Plane *cloth = new Plane(cloth_pgrm.glid, modelCloth, playback ? playback->gridN() : 128); // N = 128 OK -> put scale to 0.04f if N=128
     
     // DEBUG
     // glm::mat4x4 modelCloth = glm::scale(glm::mat4(1.0f), glm::vec3(0.08f, 1.0f, 0.08f));
@@ -85,7 +113,7 @@ int main()
     // Plane *cloth = new Plane(cloth_pgrm.glid, modelCloth, 32); // N = 128 OK -> put scale to 0.04f if N=128
     
 
-    Simulation *sim = new Simulation(cloth);
+    Simulation *sim = playback ? nullptr : new Simulation(cloth); // (no solver nor colliders when playing a cache)
     
     glm::mat4 scaleGround = glm::scale(glm::mat4(1.0f), 3000.0f*glm::vec3(1.0f, 0.0f, 1.0f));
     glm::mat4 modelGround = glm::translate(glm::mat4(1.0f), -1000.0f*glm::vec3(1.0f, 0.0f, 1.0f))*scaleGround;
@@ -99,21 +127,37 @@ int main()
 
     glm::mat4 scaleCollider = glm::scale(glm::mat4(1.0f), 0.03f*glm::vec3(1.0f, 1.0f, 1.0f));
     glm::mat4 transCollider = glm::translate(glm::mat4(1.0f), glm::vec3(5.0f, 3.0f, 5.0f));
+    if (isSDFScene)
+    {
+        scaleCollider = glm::scale(glm::mat4(1.0f), 0.015f*glm::vec3(1.0f, 1.0f, 1.0f));
+        transCollider = glm::translate(glm::mat4(1.0f), glm::vec3(3.8f, 0.6f, 3.9f)); // (on the ground, under the cloth)
+    }
     glm::mat4 modelCollider = transCollider*scaleCollider;
-    MeshFromPLY *anotherCollider = new MeshFromPLY(simple_pgrm.glid, modelCollider, "../assets/teapot.ply");
+    MeshFromAsset *anotherCollider = new MeshFromAsset(simple_pgrm.glid, modelCollider, "../assets/teapot.ply"); // (preprocessed by asset_converter)
 
 
     scaleCollider = glm::scale(glm::mat4(1.0f), 0.38f*glm::vec3(1.5f, 1.0f, 1.0f));
     glm::mat4 rotCollider = glm::rotate(glm::mat4(1.0f), 3.14159266f/2.0f, glm::vec3(0.0f, 1.0f, 0.0f));
     transCollider = glm::translate(glm::mat4(1.0f), glm::vec3(-7.0f, 1.50f, 5.0f));
     modelCollider = rotCollider*transCollider*scaleCollider;
-    MeshFromOBJ *anotherCollider2 = new MeshFromOBJ(simple_pgrm.glid, modelCollider, "../assets/heart.obj");
+    MeshFromAsset *anotherCollider2 = new MeshFromAsset(simple_pgrm.glid, modelCollider, "../assets/heart.obj");
 
 
     Mesh *chosenCollider = sphere;
-    sim->addCollider(ground);
-    sim->addCollider(chosenCollider);
-    // sim->addCollider(cloth);
+    if (sim && isAnalyticScene)
+    {
+        // sphere and ground as analytic colliders (the meshes are only drawn), the sphere spins like the mesh one
+        sim->addAnalyticCollider(AnalyticShape::plane(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+        sim->addAnalyticCollider(AnalyticShape::sphere(glm::vec3(modelSphere[3]), 1.0f));
+    }
+    else if (sim)
+    {
+        sim->addCollider(ground, nullptr, simParams.proxyTolerance, simParams.proxyTriangles);
+        sim->addCollider(chosenCollider, nullptr, simParams.proxyTolerance, simParams.proxyTriangles);
+    }
+    if (sim && isSDFScene) sim->addSDFCollider(anotherCollider, simParams.sdfResolution); // static : distance field instead of its BVH
+    std::chrono::duration<double> sceneTime = std::chrono::steady_clock::now() - sceneStart;
+    std::cout << "Scene set up in " << sceneTime.count()*1000.0 << " ms" << std::endl;
 
 
     cudaDeviceProp prop;
@@ -142,7 +186,8 @@ int main()
         keyboard_callback(window);
 
         // run simulation 
-        sim->run(currentFrame, simParams);
+        if (sim) sim->run(currentFrame, simParams);
+        else playback->update(cloth, dt);
 
         // camera matrices
         glm::mat4 projection = camera.projectionMatrix(w_width, w_height);
@@ -151,11 +196,16 @@ int main()
         simple_pgrm.use();
         simple_pgrm.setMat4("projection", projection);
         simple_pgrm.setMat4("view", view);        
-        simple_pgrm.setMat4("model", glm::mat4(1.0f));
+        simple_pgrm.setMat4("model", sim ? sim->collisionSolver()->colliderTransform(chosenCollider) : glm::mat4(1.0f)); // rigid colliders are moved by their pose
         simple_pgrm.setVec3("camera_pos", camera.pos());
         GLenum wireframeMode = gui->colliderWireframe ? GL_LINE : GL_FILL;
         glPolygonMode(GL_FRONT_AND_BACK,  wireframeMode);
         chosenCollider->draw();
+        if (isSDFScene)
+        {
+            simple_pgrm.setMat4("model", glm::mat4(1.0f));
+            anotherCollider->draw();
+        }
 
         ground_pgrm.use();
         ground_pgrm.setMat4("projection", projection);
@@ -174,7 +224,8 @@ int main()
         glPolygonMode(GL_FRONT_AND_BACK,  wireframeMode);
         cloth->draw();
 
-        gui->buildWindow(sim, &simParams, cloth); // TODO delete cast when implementing Implicit Solver <!>
+        if (sim) gui->buildWindow(sim, &simParams, cloth); // TODO delete cast when implementing Implicit Solver <!>
+        else gui->buildPlaybackWindow(playback, &simParams, cloth);
         gui->render();
 
         glfwSwapBuffers(window);
@@ -0,0 +1,83 @@
+#include "../include/obj_parser.h"
+
+#include <cstdio>
+#include <string>
+
+// Regression checks of the OBJ parser (see obj_parser.h) : the result must not depend on the number of threads, in
+// particular for relative (negative) indices pointing into an earlier chunk. Returns the number of failed checks.
+
+int nbFailed = 0;
+
+void check(bool isOk, const std::string &what)
+{
+    if (!isOk)
+    {
+        printf("FAILED : %s\n", what.c_str());
+        nbFailed++;
+    }
+}
+
+bool writeFile(const std::string &path, const std::string &text)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool isWritten = fwrite(text.data(), 1, text.size(), file) == text.size();
+    return (fclose(file) == 0) && isWritten;
+}
+
+void checkRelativeIndices()
+{
+    // 6 vertices, then enough padding for the faces to fall in later chunks whatever the thread count
+    std::string text = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0 0 1\nv 1 0 1\n";
+    for (int k = 0; k < 2000; ++k) text += "# padding padding padding padding\n";
+    text += "f -6 -5 -4\nf -3 -2 -1\nf 1 -3 6\n";
+    const std::string path = "obj_parser_test_relative.obj";
+    check(writeFile(path, text), "write " + path);
+
+    const glm::vec3 vertices[6] = {glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 0, 1),
+        glm::vec3(1, 0, 1)};
+    const int expected[9] = {0, 1, 2, 3, 4, 5, 0, 3, 5}; // vertices of the corners
+    for (int nbThreads = 1; nbThreads <= 16; nbThreads *= 2)
+    {
+        OBJMesh mesh;
+        std::string name = "relative indices, " + std::to_string(nbThreads) + " threads";
+        if (!OBJParser(nbThreads).parse(path, mesh))
+        {
+            check(false, name + " : parse");
+            continue;
+        }
+        check(mesh.indices.size() == 9 && mesh.positions.size() == 6, name + " : counts");
+        for (int c = 0; c < (int) mesh.indices.size() && c < 9; ++c)
+        {
+            check(mesh.positions[mesh.indices[c]] == vertices[expected[c]], name + " : corner " + std::to_string(c));
+        }
+    }
+    remove(path.c_str());
+
+    // pointing before the first vertex of the file
+    check(writeFile(path, "v 0 0 0\nv 1 0 0\nv 1 1 0\nf -4 -2 -1\n"), "write " + path);
+    for (int nbThreads = 1; nbThreads <= 4; nbThreads *= 2)
+    {
+        OBJMesh mesh;
+        check(!OBJParser(nbThreads).parse(path, mesh), "index before the file's start rejected, " + std::to_string(nbThreads) + " threads");
+    }
+    remove(path.c_str());
+}
+
+void checkSignedZeros()
+{
+    // -0 and +0 are the same value : one vertex
+    const std::string path = "obj_parser_test_zeros.obj";
+    check(writeFile(path, "v 0 0 0\nv -0 0 -0\nv 1 0 0\nv 0 1 0\nf 1 3 4\nf 2 3 4\n"), "write " + path);
+    OBJMesh mesh;
+    check(OBJParser(1).parse(path, mesh) && mesh.positions.size() == 3, "signed zeros welded");
+    remove(path.c_str());
+}
+
+int main()
+{
+    checkRelativeIndices();
+    checkSignedZeros();
+    printf("obj_parser_test : %s\n", nbFailed == 0 ? "passed" : "FAILED");
+    return nbFailed;
+}
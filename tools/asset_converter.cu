@@ -0,0 +1,103 @@
+#include "../include/asset_format.hcu"
+#include "../include/decimation.h"
+
+#include <dirent.h>
+#include <string>
+#include <algorithm>
+
+// Offline converter of the collider meshes into scene assets (see asset_format.hcu) : each source is loaded, decimated
+// into its collision proxy, its BVH built, then everything is written next to it as <source>.asset. The asset is mapped
+// back to check it and compare its loading time with the one of the source.
+// Usage : asset_converter [-s scene scale] [-t proxy tolerance in cloth thicknesses, 0 = full mesh] [mesh.ply|mesh.obj ...]
+//         (the tolerance is converted to object units with the scene scale, by default every mesh of ../assets is converted)
+
+bool hasExtension(const std::string &path, const char *extension)
+{
+    size_t n = strlen(extension);
+    return path.size() > n && path.compare(path.size()-n, n, extension) == 0;
+}
+
+std::vector<std::string> listAssets(const std::string &directory)
+{
+    std::vector<std::string> sources;
+    DIR *dir = opendir(directory.c_str());
+    if (!dir) return sources;
+    while (struct dirent *entry = readdir(dir))
+    {
+        std::string path = directory + "/" + entry->d_name;
+        if (hasExtension(path, ".ply") || hasExtension(path, ".obj")) sources.push_back(path);
+    }
+    closedir(dir);
+    std::sort(sources.begin(), sources.end());
+    return sources;
+}
+
+int main(int argc, char **argv)
+{
+    float sceneScale = 1.0f;
+    float tolerance = PROXY_TOLERANCE;
+    std::vector<std::string> sources;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-s" && i+1 < argc) sceneScale = atof(argv[++i]);
+        else if (arg == "-t" && i+1 < argc) tolerance = atof(argv[++i]);
+        else sources.push_back(arg);
+    }
+    if (sources.empty()) sources = listAssets("../assets");
+    float objectTolerance = tolerance*HOST_CLOTH_THICKNESS/sceneScale;
+
+    glm::mat4 identity(1.0f);
+    std::vector<std::string> report;
+    for (const std::string &source : sources)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Data data = hasExtension(source, ".obj") ? MeshFromOBJ::init_mesh(identity, source) : MeshFromPLY::init_mesh(identity, source);
+        if (data.indices.empty() || data.normals.size() != data.vertices.size())
+        {
+            report.push_back(source + " : could not be loaded");
+            continue;
+        }
+
+        int nbMeshTriangles = data.indices.size()/3;
+        BVH *bvh;
+        float proxyError = 0.0f;
+        if (objectTolerance > 0.0f)
+        {
+            CollisionProxy proxy = decimateMesh(data.vertices, data.indices, 0, objectTolerance, true);
+            bvh = new BVH(proxy.vertices, proxy.indices);
+            proxyError = proxy.error;
+        }
+        else bvh = new BVH(data.vertices, data.indices);
+        std::chrono::duration<double> sourceTime = std::chrono::steady_clock::now() - start;
+
+        glm::vec3 color = data.color.empty() ? glm::vec3(0.9f) : data.color[0];
+        if (!writeAsset(assetPath(source), source, data, *bvh, nbMeshTriangles, objectTolerance, proxyError, color))
+        {
+            report.push_back(source + " : could not write " + assetPath(source));
+            delete bvh;
+            continue;
+        }
+
+        start = std::chrono::steady_clock::now();
+        MeshFromAsset::Contents contents;
+        bool isMapped = MeshFromAsset::init_mapped_mesh(identity, source, contents);
+        std::chrono::duration<double> mapTime = std::chrono::steady_clock::now() - start;
+
+        bool isSame = isMapped && contents.data.vertices == data.vertices && contents.data.indices == data.indices
+            && contents.bvh->getNbNodes() == bvh->getNbNodes() && contents.bvh->getNbHotTri() == bvh->getNbHotTri()
+            && memcmp(contents.bvh->hotTriangles(), bvh->hotTriangles(), sizeof(HotTriangle)*bvh->getNbHotTri()) == 0;
+
+        char line[512];
+        snprintf(line, sizeof(line), "%-28s %8i tris -> BVH of %7i tris (error %.5f) | source + build %8.1f ms, asset %6.2f ms%s",
+            source.c_str(), nbMeshTriangles, bvh->getNbTri(), proxyError, sourceTime.count()*1000.0, mapTime.count()*1000.0,
+            isSame ? "" : " <!> MISMATCH");
+        report.push_back(line);
+        delete contents.bvh;
+        delete bvh;
+    }
+
+    printf("\n---------------- SCENE ASSETS (proxy tolerance %.5f object units) ----------------\n", objectTolerance);
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
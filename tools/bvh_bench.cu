@@ -0,0 +1,127 @@
+#include "../include/bvh4.h"
+
+#include <random>
+#include <string>
+
+// Compares the ray-query throughput of the binary BVH and of the 4-wide SIMD BVH on the CPU.
+// Usage : bvh_bench [nbClothVertices] [mesh.ply ...]
+
+struct ClothRays
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+};
+
+void normalizeMesh(Data &data, float diagonal)
+{
+    /**
+     * Rescales the mesh so that its bounding box diagonal has the given length (same scale as the simulated scene)
+    */
+    AABB box;
+    for (glm::vec3 &v : data.vertices)
+    {
+        box.aabbMin = min(box.aabbMin, v);
+        box.aabbMax = max(box.aabbMax, v);
+    }
+    glm::vec3 diff = box.aabbMax - box.aabbMin;
+    float scale = diagonal/sqrt(dot(diff, diff));
+    for (glm::vec3 &v : data.vertices) v = (v - box.aabbMin)*scale;
+}
+
+ClothRays sampleClothRays(BVH &bvh, int nbVertices, unsigned int seed)
+{
+    /**
+     * Cloth vertices resting on the collider : random points slightly above its surface,
+     * with a normal close to the surface's one (as for a draped cloth)
+    */
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> triDistrib(0, bvh.getNbTri()-1);
+    std::uniform_real_distribution<float> unitDistrib(0.0f, 1.0f);
+
+    ClothRays rays;
+    for (int k = 0; k < nbVertices; ++k)
+    {
+        Triangle &tri = bvh.tri()[triDistrib(gen)];
+        float u = unitDistrib(gen);
+        float v = unitDistrib(gen);
+        if (u + v > 1.0f)
+        {
+            u = 1.0f - u;
+            v = 1.0f - v;
+        }
+        glm::vec3 n = normalize(tri.normal);
+        glm::vec3 jitter = 0.2f*glm::vec3(unitDistrib(gen) - 0.5f, unitDistrib(gen) - 0.5f, unitDistrib(gen) - 0.5f);
+
+        rays.positions.push_back(tri.p0 + u*(tri.p1 - tri.p0) + v*(tri.p2 - tri.p0) + 0.5f*HOST_CLOTH_THICKNESS*n);
+        rays.normals.push_back(normalize(n + jitter));
+    }
+    return rays;
+}
+
+int main(int argc, char **argv)
+{
+    int nbVertices = argc > 1 ? atoi(argv[1]) : 128*128;
+    std::vector<std::string> assets;
+    for (int i = 2; i < argc; ++i) assets.push_back(argv[i]);
+    if (assets.empty()) assets = {"../assets/teapot.ply", "../assets/bunny.ply", "../assets/testBuddha.ply"};
+
+    int nbThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    glm::mat4 identity(1.0f);
+
+    std::vector<std::string> report;
+    for (const std::string &asset : assets)
+    {
+        Data data = MeshFromPLY::init_mesh(identity, asset);
+        if (data.indices.empty()) continue;
+        normalizeMesh(data, 4.0f);
+
+        BVH bvh(data.vertices, data.indices);
+        BVH4 bvh4(&bvh);
+        ClothRays rays = sampleClothRays(bvh, nbVertices, 42);
+
+        // binary tree, scalar traversal
+        RayQueryStats binStats = {0, 0, 0};
+        std::vector<RayHit> binHits(nbVertices);
+        auto start = std::chrono::steady_clock::now();
+        for (int v = 0; v < nbVertices; ++v)
+        {
+            RayHit hit = {-1, glm::vec4(10e30f)};
+            intersectBinary(&bvh, rays.positions[v], -rays.normals[v], hit, binStats);
+            intersectBinary(&bvh, rays.positions[v], rays.normals[v], hit, binStats);
+            binHits[v] = hit;
+        }
+        std::chrono::duration<double> binTime = std::chrono::steady_clock::now() - start;
+
+        // 4-wide tree, SIMD box tests (1 thread, then all threads)
+        std::vector<RayHit> hits4(nbVertices);
+        start = std::chrono::steady_clock::now();
+        RayQueryStats stats4 = queryClothRays(&bvh4, rays.positions.data(), rays.normals.data(), nbVertices, hits4.data(), 1);
+        std::chrono::duration<double> time4 = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        queryClothRays(&bvh4, rays.positions.data(), rays.normals.data(), nbVertices, hits4.data(), nbThreads);
+        std::chrono::duration<double> time4MT = std::chrono::steady_clock::now() - start;
+
+        int nbHits = 0;
+        int nbMismatches = 0;
+        for (int v = 0; v < nbVertices; ++v)
+        {
+            nbHits += binHits[v].triIdx >= 0;
+            nbMismatches += binHits[v].triIdx != hits4[v].triIdx;
+        }
+
+        char line[512];
+        snprintf(line, sizeof(line),
+            "%-28s %8i tris | binary %7.2f Mq/s %6.1f nodes/q | BVH4 %7.2f Mq/s %6.1f nodes/q (x%.2f) | BVH4 %i threads %7.2f Mq/s | hits %i, mismatches %i",
+            asset.c_str(), bvh.getNbTri(),
+            binStats.queries/binTime.count()*1e-6, binStats.nodesVisited/(float) binStats.queries,
+            stats4.queries/time4.count()*1e-6, stats4.nodesVisited/(float) stats4.queries, binTime.count()/time4.count(),
+            nbThreads, stats4.queries/time4MT.count()*1e-6,
+            nbHits, nbMismatches);
+        report.push_back(line);
+    }
+
+    printf("\n---------------- RAY QUERIES (%i cloth vertices, 2 segments each) ----------------\n", nbVertices);
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
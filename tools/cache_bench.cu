@@ -0,0 +1,79 @@
+#include "../include/point_cache.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+
+// Compressed point cache : compression ratio, encode / decode throughput, random frame access and reconstruction
+// error for several quantizations, on a synthetic cloth animation (N*N grid falling and folding with travelling waves).
+// Usage : cache_bench [N] [frames] [keyframe interval]
+
+void clothFrame(int N, int f, std::vector<glm::vec3> &positions)
+{
+    float t = f/60.0f;
+    float spacing = 4.0f/N;
+    float height = std::max(2.2f - 0.5f*9.81f*0.15f*t*t, 0.5f);
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            float x = j*spacing;
+            float z = i*spacing;
+            float wave = 0.3f*sin(3.0f*x + 2.0f*t)*cos(2.0f*z + 1.3f*t);
+            float fold = 0.5f*std::min(t, 2.0f)*exp(-(x-2.0f)*(x-2.0f));
+            positions[j*N + i] = glm::vec3(x + 0.02f*sin(5.0f*z + t), height + wave + fold, z);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int N = argc > 1 ? atoi(argv[1]) : 512;
+    int nbFrames = argc > 2 ? atoi(argv[2]) : 120;
+    int keyframeInterval = argc > 3 ? atoi(argv[3]) : 30;
+    std::string path = "cache_bench.pcache";
+
+    std::vector<std::vector<glm::vec3>> frames(nbFrames, std::vector<glm::vec3>(N*N));
+    for (int f = 0; f < nbFrames; ++f) clothFrame(N, f, frames[f]);
+    double rawMB = nbFrames*N*N*sizeof(glm::vec3)*1e-6;
+
+    std::vector<std::string> report;
+    for (int bits : {12, 16, 20, (int) CACHE_RAW_BITS})
+    {
+        auto start = std::chrono::steady_clock::now();
+        PointCacheWriter writer(path, N*N, N, bits, keyframeInterval, 1.0f/60.0f);
+        for (int f = 0; f < nbFrames; ++f) writer.writeFrame(frames[f].data());
+        writer.close();
+        std::chrono::duration<double> encodeTime = std::chrono::steady_clock::now() - start;
+
+        PointCacheReader reader(path);
+        std::vector<glm::vec3> decoded(N*N);
+        float maxError = 0.0f;
+        start = std::chrono::steady_clock::now();
+        for (int f = 0; f < nbFrames; ++f)
+        {
+            if (!reader.readFrame(f, decoded.data())) return -1;
+            for (int k = 0; k < N*N; ++k) maxError = std::max(maxError, glm::length(decoded[k] - frames[f][k]));
+        }
+        std::chrono::duration<double> decodeTime = std::chrono::steady_clock::now() - start;
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> frameDistrib(0, nbFrames-1);
+        const int nbSeeks = 20;
+        start = std::chrono::steady_clock::now();
+        for (int s = 0; s < nbSeeks; ++s) reader.readFrame(frameDistrib(gen), decoded.data());
+        std::chrono::duration<double> seekTime = std::chrono::steady_clock::now() - start;
+
+        char line[512];
+        snprintf(line, sizeof(line),
+            "%2i bits : %8.1f MB -> %6.2f MB (x%5.1f) | encode %7.1f MB/s, decode %7.1f MB/s, random frame %6.2f ms | max error %.2e (encoder %.2e)",
+            bits, rawMB, writer.encodedBytes()*1e-6, rawMB/(writer.encodedBytes()*1e-6), rawMB/encodeTime.count(), rawMB/decodeTime.count(),
+            seekTime.count()*1000.0/nbSeeks, maxError, writer.maxError());
+        report.push_back(line);
+    }
+    remove(path.c_str());
+
+    printf("\n---------------- POINT CACHE (%ix%i cloth, %i frames, keyframe every %i) ----------------\n", N, N, nbFrames, keyframeInterval);
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
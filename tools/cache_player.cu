@@ -0,0 +1,81 @@
+#include "../include/cache_playback.hcu"
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+// Headless playback of a point cache (see cache_playback.hcu) : frame-to-frame latency of a forward playback and of
+// random scrubbing, from the mapped file to the cloth's buffers (upload and normals, synchronized).
+// Usage : cache_player cache.pcache [nb seeks]
+
+double percentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size()-1, (size_t) (p*(values.size()-1) + 0.5))];
+}
+
+bool timeFrames(CachePlayback &playback, Plane *cloth, const std::vector<int> &frames, std::vector<double> &times)
+{
+    times.resize(frames.size());
+    for (size_t k = 0; k < frames.size(); ++k)
+    {
+        auto start = std::chrono::steady_clock::now();
+        if (!playback.seek(cloth, frames[k])) return false;
+        cudaErrorCheck(cudaDeviceSynchronize());
+        times[k] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("Usage : cache_player cache.pcache [nb seeks]\n");
+        return -1;
+    }
+    int nbSeeks = argc > 2 ? atoi(argv[2]) : 200;
+
+    int device_count;
+    cudaErrorCheck(cudaGetDeviceCount(&device_count));
+    if (device_count == 0)
+    {
+        printf("No CUDA devices found!\n");
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CachePlayback playback(argv[1]);
+    std::chrono::duration<double, std::milli> openTime = std::chrono::steady_clock::now() - start;
+    if (!playback.isValid())
+    {
+        printf("Cannot play %s (not a cloth point cache)\n", argv[1]);
+        return -1;
+    }
+    glm::mat4 model(1.0f);
+    Plane *cloth = new Plane(HEADLESS_PROGRAM, model, playback.gridN());
+
+    std::vector<int> forward(playback.nbFrames());
+    for (int f = 0; f < playback.nbFrames(); ++f) forward[f] = f;
+    std::vector<int> scrub(nbSeeks);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> frameDistrib(0, playback.nbFrames()-1);
+    for (int &f : scrub) f = frameDistrib(gen);
+
+    std::vector<double> forwardTimes, scrubTimes;
+    if (!timeFrames(playback, cloth, forward, forwardTimes) || !timeFrames(playback, cloth, scrub, scrubTimes))
+    {
+        printf("Cannot read frame from %s\n", argv[1]);
+        return -1;
+    }
+
+    printf("\n---------------- PLAYBACK (%s : %i frames, %ix%i cloth, %s, opened in %.2f ms) ----------------\n", argv[1],
+        playback.nbFrames(), playback.gridN(), playback.gridN(), playback.isRaw() ? "raw" : "encoded", openTime.count());
+    printf("forward : median %7.3f ms, p95 %7.3f, max %7.3f\n", percentile(forwardTimes, 0.5), percentile(forwardTimes, 0.95),
+        percentile(forwardTimes, 1.0));
+    printf("scrub   : median %7.3f ms, p95 %7.3f, max %7.3f (%i random frames)\n", percentile(scrubTimes, 0.5), percentile(scrubTimes, 0.95),
+        percentile(scrubTimes, 1.0), nbSeeks);
+
+    delete cloth;
+    return 0;
+}
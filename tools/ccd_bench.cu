@@ -0,0 +1,194 @@
+#include "../include/bvh4.h"
+#include "../include/ccd.hcu"
+
+#include <string>
+
+// Number of substeps per frame needed to get zero tunneling, with the discrete detection only (segment along -n of
+// length CLOTH_THICKNESS, as CollisionSolver::solve) and with the continuous detection before it.
+// Two scenes : cloth vertices falling on a thin sheet, and a thin blade rotating through resting vertices (like the
+// rotation kernel does with the last collider).
+// Usage : ccd_bench
+
+const float FRAME_TIME = 1.0f/60.0f;
+const int MAX_SUBSTEPS = 1024;
+
+struct Particle
+{
+    glm::vec3 x;
+    glm::vec3 v;
+    glm::vec3 n; // cloth normal at the vertex
+};
+
+struct Sheet
+{
+    glm::vec3 p[4]; // quad p0 p1 p2 p3 = 2 triangles (p0, p1, p2) and (p0, p2, p3)
+};
+
+HotTriangle hotTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c)
+{
+    HotTriangle tri;
+    tri.p0 = glm::vec4(a, 0.0f);
+    tri.e1 = glm::vec4(b - a, 0.0f);
+    tri.e2 = glm::vec4(c - a, 0.0f);
+    return tri;
+}
+
+bool discreteContact(Particle &particle, const Sheet &sheet)
+{
+    /**
+     * Discrete detection + response of the solver : segment along -n, vertex moved slightly above the hit point
+    */
+    glm::vec4 hitInfo = glm::vec4(10e30f);
+    bool isHit = false;
+    HotTriangle tris[2] = {hotTriangle(sheet.p[0], sheet.p[1], sheet.p[2]), hotTriangle(sheet.p[0], sheet.p[2], sheet.p[3])};
+    for (int k = 0; k < 2; ++k) isHit |= hostIntersectSegmentTriangle(particle.x, -particle.n, tris[k], &hitInfo);
+    if (!isHit) return false;
+
+    glm::vec3 n = normalize(cross(sheet.p[1] - sheet.p[0], sheet.p[2] - sheet.p[0]));
+    if (dot(n, particle.n) < 0.0f) n = -n;
+    particle.x = glm::vec3(hitInfo) + 0.1f*HOST_CLOTH_THICKNESS*n;
+    particle.n = n; // the pushed cloth lies on the collider
+    float vN = dot(particle.v, n);
+    if (vN < 0.0f) particle.v -= vN*n;
+    return true;
+}
+
+bool continuousContact(Particle &particle, glm::vec3 prevX, const Sheet &prevSheet, const Sheet &sheet)
+{
+    /**
+     * Continuous detection + response (same as ccdResponse) over the substep
+    */
+    CCDContact best = {2.0f, glm::vec3(0.0f), glm::vec3(0.0f)};
+    int tris[2][3] = {{0, 1, 2}, {0, 2, 3}};
+    for (int k = 0; k < 2; ++k)
+    {
+        glm::vec3 d[3];
+        for (int c = 0; c < 3; ++c) d[c] = sheet.p[tris[k][c]] - prevSheet.p[tris[k][c]];
+        CCDContact contact;
+        if (vertexTriangleCCD(prevX, particle.x - prevX,
+            prevSheet.p[tris[k][0]], d[0], prevSheet.p[tris[k][1]], d[1], prevSheet.p[tris[k][2]], d[2], contact)
+            && contact.toi < best.toi) best = contact;
+    }
+    if (best.toi > 1.0f) return false;
+
+    glm::vec3 xToi = prevX + best.toi*(particle.x - prevX);
+    particle.x = xToi + (1.0f - best.toi)*best.colliderDisp + 0.1f*HOST_CLOTH_THICKNESS*best.n;
+    particle.n = best.n;
+    float vN = dot(particle.v, best.n);
+    if (vN < 0.0f) particle.v -= vN*best.n;
+    return true;
+}
+
+int fallingTunnels(float speed, int nbSubSteps, bool isCCD)
+{
+    /**
+     * 32 x 32 vertices falling at the given speed (+ gravity) on a 4 x 4 sheet of null thickness, for 1 s
+    */
+    Sheet sheet = {{glm::vec3(-2.0f, 0.0f, -2.0f), glm::vec3(-2.0f, 0.0f, 2.0f), glm::vec3(2.0f, 0.0f, 2.0f), glm::vec3(2.0f, 0.0f, -2.0f)}};
+    std::vector<Particle> particles;
+    for (int k = 0; k < 32*32; ++k)
+    {
+        glm::vec3 x = glm::vec3(-1.5f + 3.0f*(k%32)/31.0f, 0.5f + 0.01f*(k%7), -1.5f + 3.0f*(k/32)/31.0f);
+        particles.push_back(Particle {x, glm::vec3(0.0f, -speed, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)});
+    }
+
+    float h = FRAME_TIME/nbSubSteps;
+    int nbSteps = int(1.0f/h);
+    for (Particle &particle : particles)
+    {
+        for (int step = 0; step < nbSteps; ++step)
+        {
+            glm::vec3 prevX = particle.x;
+            particle.v += h*glm::vec3(0.0f, -9.81f, 0.0f);
+            particle.x += h*particle.v;
+            if (isCCD) continuousContact(particle, prevX, sheet, sheet);
+            discreteContact(particle, sheet);
+        }
+    }
+
+    int nbTunnels = 0;
+    for (Particle &particle : particles) nbTunnels += particle.x.y < 0.0f;
+    return nbTunnels;
+}
+
+Sheet bladeAt(float angle)
+{
+    // vertical blade of the plane containing the y axis, from r = 0 to r = 2 and y = 0 to y = 1, facing the direction of
+    // rotation (the segments test is one-sided)
+    glm::vec3 dir = glm::vec3(cos(angle), 0.0f, sin(angle));
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    return Sheet {{glm::vec3(0.0f), 2.0f*dir, 2.0f*dir + up, up}};
+}
+
+int bladeTunnels(float angularSpeed, int nbSubSteps, bool isCCD)
+{
+    /**
+     * A blade rotating at the given angular speed sweeps resting vertices (no gravity) during 3/4 of a turn.
+     * Vertex normals face the blade, the best case for the discrete detection.
+    */
+    std::vector<Particle> particles;
+    for (int k = 0; k < 32*32; ++k)
+    {
+        float r = 0.2f + 1.6f*(k%32)/31.0f;
+        float th = 0.1f + 1.3f*(k/32)/31.0f; // in front of the blade (angle 0 at start)
+        glm::vec3 eTh = glm::vec3(-sin(th), 0.0f, cos(th));
+        particles.push_back(Particle {glm::vec3(r*cos(th), 0.5f, r*sin(th)), glm::vec3(0.0f), eTh});
+    }
+
+    float h = FRAME_TIME/nbSubSteps;
+    float duration = 1.5f*3.14159265f/angularSpeed;
+    int nbSteps = int(duration/h);
+    int nbTunnels = 0;
+    for (Particle &particle : particles)
+    {
+        float angle = 0.0f;
+        bool isTunneled = false;
+        for (int step = 0; step < nbSteps && !isTunneled; ++step)
+        {
+            Sheet prevBlade = bladeAt(angle);
+            angle += angularSpeed*h;
+            Sheet blade = bladeAt(angle);
+
+            glm::vec3 prevX = particle.x;
+            if (isCCD) continuousContact(particle, prevX, prevBlade, blade);
+            discreteContact(particle, blade);
+
+            // the blade passed the vertex : it is behind it (angle of the vertex < angle of the blade)
+            float th = atan2(particle.x.z, particle.x.x);
+            if (th < 0.0f) th += 2.0f*3.14159265f;
+            isTunneled = th < angle - 1e-3f && angle < 2.0f*3.14159265f;
+        }
+        nbTunnels += isTunneled;
+    }
+    return nbTunnels;
+}
+
+template <typename Scene>
+int substepsForZeroTunneling(Scene scene, float speed, bool isCCD)
+{
+    for (int nbSubSteps = 1; nbSubSteps <= MAX_SUBSTEPS; nbSubSteps *= 2)
+    {
+        if (scene(speed, nbSubSteps, isCCD) == 0) return nbSubSteps;
+    }
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    printf("\n---------------- SUBSTEPS PER FRAME (1/60 s) NEEDED FOR ZERO TUNNELING (-1 : > %i) ----------------\n", MAX_SUBSTEPS);
+
+    float speeds[] = {2.0f, 10.0f, 50.0f};
+    for (float speed : speeds)
+    {
+        printf("falling on a sheet, %5.1f units/s    : discrete %5i | continuous %5i\n", speed,
+            substepsForZeroTunneling(fallingTunnels, speed, false), substepsForZeroTunneling(fallingTunnels, speed, true));
+    }
+
+    float angularSpeeds[] = {1.0f, 5.0f, 20.0f};
+    for (float angularSpeed : angularSpeeds)
+    {
+        printf("rotating blade, %5.1f rad/s          : discrete %5i | continuous %5i\n", angularSpeed,
+            substepsForZeroTunneling(bladeTunnels, angularSpeed, false), substepsForZeroTunneling(bladeTunnels, angularSpeed, true));
+    }
+    return 0;
+}
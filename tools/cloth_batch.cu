@@ -0,0 +1,259 @@
+#include "../include/scene.h"
+#include "../include/point_cache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+// Headless batch driver : runs scene files without window nor OpenGL context (see scene.h for the format) and writes
+// per-frame timings to a csv file (one row per frame, collision counters when the scene sets param isProfiling 1).
+// The summary reports the frame time distribution and whether the cloth stayed finite. With -c, the cloth frames of each
+// scene are also stored in a compressed point cache <directory>/<scene name>.pcache (see point_cache.h), written by the
+// exporter's thread : the frame times include the snapshot and any stall when the writer falls behind.
+// With -k, the whole simulation state is saved every k frames to <checkpoint directory>/<scene name>.ckpt (see
+// checkpoint.hcu, not timed with the frames) ; with -r, a scene resumes from its checkpoint when there is one (not with
+// the point cache, which can't be appended to).
+// -x pc2 / mdd exports the frames for the DCC tools instead of the point cache (see vertex_cache.h), -F restricts the
+// exported frames to a range (a resumed scene's range starts at its restored frame, the PC2 start frame records it).
+// -x ply / obj writes a mesh per frame, <directory>/<scene name>_<frame> (see mesh_sequence.h).
+// Usage : cloth_batch [-o stats.csv] [-f frames (overrides the scenes' frame count)] [-c cache directory]
+//         [-b cache bits (32 : raw frames, see cache_player)] [-x pcache|pc2|mdd|ply|obj] [-F first:last] [-k checkpoint interval]
+//         [-d checkpoint directory] [-r] scene.scene [...]
+
+struct FrameStats
+{
+    double time; // in ms
+    unsigned long long queries;
+    unsigned long long contacts;
+    float detectionTime; // in ms
+};
+
+bool isClothFinite(Plane *cloth, glm::vec3 &boundsMin, glm::vec3 &boundsMax)
+{
+    std::vector<glm::vec3> positions(cloth->getVerticesNb());
+    cudaErrorCheck(cudaMemcpy(positions.data(), cloth->getDataPtr(0), sizeof(glm::vec3)*positions.size(), cudaMemcpyDeviceToHost));
+    boundsMin = glm::vec3(1e30f);
+    boundsMax = glm::vec3(-1e30f);
+    for (const glm::vec3 &p : positions)
+    {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) return false;
+        boundsMin = min(boundsMin, p);
+        boundsMax = max(boundsMax, p);
+    }
+    return true;
+}
+
+double percentile(std::vector<double> values, double p)
+{
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size()-1, (size_t) (p*(values.size()-1) + 0.5))];
+}
+
+int main(int argc, char **argv)
+{
+    std::string statsPath = "batch_stats.csv";
+    int nbFramesOverride = 0;
+    std::string cacheDirectory;
+    int cacheBits = 16;
+    std::string cacheFormat = "pcache";
+    int exportFirst = 0, exportLast = -1;
+    int checkpointInterval = 0;
+    std::string checkpointDirectory = ".";
+    bool isResuming = false;
+    std::vector<std::string> scenePaths;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-o" && i+1 < argc) statsPath = argv[++i];
+        else if (arg == "-f" && i+1 < argc) nbFramesOverride = atoi(argv[++i]);
+        else if (arg == "-c" && i+1 < argc) cacheDirectory = argv[++i];
+        else if (arg == "-b" && i+1 < argc) cacheBits = atoi(argv[++i]);
+        else if (arg == "-x" && i+1 < argc) cacheFormat = argv[++i];
+        else if (arg == "-F" && i+1 < argc) sscanf(argv[++i], "%i:%i", &exportFirst, &exportLast);
+        else if (arg == "-k" && i+1 < argc) checkpointInterval = atoi(argv[++i]);
+        else if (arg == "-d" && i+1 < argc) checkpointDirectory = argv[++i];
+        else if (arg == "-r") isResuming = true;
+        else scenePaths.push_back(arg);
+    }
+    if (isResuming && !cacheDirectory.empty() && cacheFormat == "pcache")
+    {
+        // (the point cache is rewritten from its first frame : a resumed scene would lose the frames before its checkpoint)
+        printf("-r : the point cache can't be resumed, export a PC2 / MDD cache (-x) or a mesh sequence instead\n");
+        return -1;
+    }
+    if (scenePaths.empty())
+    {
+        printf("Usage : cloth_batch [-o stats.csv] [-f frames] [-c dir] [-b bits] [-x format] [-F first:last] [-k interval] [-d dir] [-r] scene.scene [...]\n");
+        return -1;
+    }
+
+    int device_count;
+    cudaErrorCheck(cudaGetDeviceCount(&device_count));
+    if (device_count == 0)
+    {
+        printf("No CUDA devices found!\n");
+        return -1;
+    }
+
+    FILE *csv = fopen(statsPath.c_str(), "w");
+    if (!csv)
+    {
+        printf("Cannot write %s\n", statsPath.c_str());
+        return -1;
+    }
+    fprintf(csv, "scene,frame,frame_ms,queries,contacts,detection_ms\n");
+
+    std::vector<std::string> report;
+    int nbFailed = 0;
+    for (const std::string &path : scenePaths)
+    {
+        Scene scene;
+        std::string error;
+        if (!scene.load(path, error))
+        {
+            report.push_back(path + " : " + error);
+            nbFailed++;
+            continue;
+        }
+        int nbFrames = nbFramesOverride > 0 ? nbFramesOverride : scene.nbFrames;
+
+        auto start = std::chrono::steady_clock::now();
+        Plane *cloth;
+        std::vector<Mesh *> meshes;
+        Simulation *sim = scene.build(HEADLESS_PROGRAM, HEADLESS_PROGRAM, cloth, meshes);
+        cudaErrorCheck(cudaDeviceSynchronize());
+        std::chrono::duration<double> setupTime = std::chrono::steady_clock::now() - start;
+
+        std::string fileName = scene.name;
+        std::replace(fileName.begin(), fileName.end(), '/', '_'); // (the name is the scene's path when it has none)
+        std::string checkpointPath = checkpointDirectory + "/" + fileName + ".ckpt";
+        int firstFrame = (isResuming && sim->restoreCheckpoint(checkpointPath) == CHECKPOINT_RESTORED) ? std::min(sim->frame(), nbFrames) : 0;
+
+        if (!cacheDirectory.empty() && cacheFormat == "pcache")
+        {
+            sim->startExport(cacheDirectory + "/" + fileName + ".pcache", scene.params.timeStep*scene.params.nbSubSteps, cacheBits);
+        }
+        else if (!cacheDirectory.empty() && (cacheFormat == "ply" || cacheFormat == "obj"))
+        {
+            sim->startExport(cacheDirectory + "/" + fileName, cacheFormat == "obj" ? MESH_SEQUENCE_OBJ : MESH_SEQUENCE_PLY);
+        }
+        else if (!cacheDirectory.empty())
+        {
+            // a resumed run starts its cache at the restored frame (the writer expects the frames of its range without gaps)
+            VertexCacheFormat format = cacheFormat == "mdd" ? VERTEX_CACHE_MDD : VERTEX_CACHE_PC2;
+            int firstExported = std::max(exportFirst, firstFrame);
+            int lastFrame = (format == VERTEX_CACHE_MDD && exportLast < 0) ? nbFrames-1 : exportLast; // (bounded range)
+            sim->startExport(cacheDirectory + "/" + fileName + "." + cacheFormat, format, 60.0f, firstExported, lastFrame);
+        }
+
+        std::vector<FrameStats> frames(nbFrames);
+        float currentTime = firstFrame*scene.params.timeStep*scene.params.nbSubSteps;
+        int nbCheckpoints = 0;
+        int nbCheckpointsFailed = 0;
+        double checkpointTime = 0.0;
+        for (int f = firstFrame; f < nbFrames; ++f)
+        {
+            start = std::chrono::steady_clock::now();
+            sim->run(currentTime, scene.params);
+            cudaErrorCheck(cudaDeviceSynchronize());
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            currentTime += scene.params.timeStep*scene.params.nbSubSteps;
+
+            const CollisionStats &stats = sim->collisionSolver()->stats();
+            bool isProfiled = scene.params.isProfiling;
+            frames[f] = FrameStats {elapsed.count()*1000.0, isProfiled ? stats.queries : 0, isProfiled ? stats.contacts : 0,
+                isProfiled ? sim->collisionSolver()->detectionTime() : 0.0f};
+
+            if (checkpointInterval > 0 && (f+1) % checkpointInterval == 0)
+            {
+                start = std::chrono::steady_clock::now();
+                bool isSaved = sim->saveCheckpoint(checkpointPath);
+                checkpointTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                nbCheckpoints++;
+                nbCheckpointsFailed += !isSaved;
+            }
+        }
+
+        int nbRunFrames = nbFrames - firstFrame;
+        std::vector<double> times(std::max(nbRunFrames, 1), 0.0);
+        double total = 0.0;
+        for (int f = firstFrame; f < nbFrames; ++f)
+        {
+            fprintf(csv, "%s,%i,%.4f,%llu,%llu,%.4f\n", scene.name.c_str(), f, frames[f].time, frames[f].queries, frames[f].contacts,
+                frames[f].detectionTime);
+            times[f - firstFrame] = frames[f].time;
+            total += frames[f].time;
+        }
+
+        glm::vec3 boundsMin, boundsMax;
+        bool isFinite = isClothFinite(cloth, boundsMin, boundsMax);
+        nbFailed += !isFinite;
+
+        char line[512];
+        snprintf(line, sizeof(line),
+            "%-32s %5i frames, setup %8.1f ms | frame mean %7.3f ms, median %7.3f, p95 %7.3f, max %7.3f | cloth %s (y in [%.3f, %.3f])",
+            scene.name.c_str(), nbRunFrames, setupTime.count()*1000.0, total/std::max(nbRunFrames, 1), percentile(times, 0.5), 
+            percentile(times, 0.95), percentile(times, 1.0), isFinite ? "finite" : "NOT FINITE", boundsMin.y, boundsMax.y);
+        report.push_back(line);
+        if (firstFrame > 0)
+        {
+            snprintf(line, sizeof(line), "%-32s resumed at frame %i from %s", "", firstFrame, checkpointPath.c_str());
+            report.push_back(line);
+        }
+        if (nbCheckpoints > 0)
+        {
+            snprintf(line, sizeof(line), "%-32s checkpoints : %i written to %s, %.1f ms each%s", "", nbCheckpoints - nbCheckpointsFailed,
+                checkpointPath.c_str(), checkpointTime*1000.0/nbCheckpoints, nbCheckpointsFailed > 0 ? ", WRITE FAILED" : "");
+            report.push_back(line);
+            nbFailed += nbCheckpointsFailed > 0;
+        }
+        if (PointCacheWriter *cache = sim->cacheWriter())
+        {
+            FrameExporter *exporter = sim->exporter();
+            exporter->flush();
+            snprintf(line, sizeof(line), "%-32s point cache : %i frames, %.1f MB -> %.2f MB (x%.1f), max error %.2e", "", cache->nbFrames(),
+                cache->rawBytes()*1e-6, cache->encodedBytes()*1e-6, cache->rawBytes()/(double) std::max<size_t>(cache->encodedBytes(), 1),
+                cache->maxError());
+            report.push_back(line);
+            snprintf(line, sizeof(line), "%-32s export : writer %.2f ms per frame, simulation stalled %.1f ms in total%s", "",
+                exporter->writeTime()*1000.0/std::max(nbRunFrames, 1), exporter->stallTime()*1000.0, exporter->nbFailed() > 0 ? ", WRITE FAILED" : "");
+            report.push_back(line);
+            nbFailed += exporter->nbFailed() > 0;
+            sim->stopExport();
+        }
+        if (VertexCacheWriter *cache = sim->vertexCacheWriter())
+        {
+            FrameExporter *exporter = sim->exporter();
+            exporter->flush();
+            double writeTime = std::max(exporter->writeTime(), 1e-9);
+            snprintf(line, sizeof(line), "%-32s %s : %i frames, %.1f MB, writer %.1f MB/s (%.0f frames/s), simulation stalled %.1f ms%s", "",
+                cacheFormat.c_str(), cache->nbFrames(), cache->bytes()*1e-6, cache->bytes()*1e-6/writeTime, cache->nbFrames()/writeTime, 
+                exporter->stallTime()*1000.0, exporter->nbFailed() > 0 ? ", WRITE FAILED" : "");
+            report.push_back(line);
+            nbFailed += exporter->nbFailed() > 0;
+            sim->stopExport();
+        }
+        if (MeshSequenceWriter *sequence = sim->meshWriter())
+        {
+            FrameExporter *exporter = sim->exporter();
+            exporter->flush();
+            int nbWritten = std::max(sequence->nbFrames(), 1);
+            snprintf(line, sizeof(line), "%-32s %s : %i frames, %.1f MB, format %.2f ms + write %.2f ms per frame (%.1f MB/s), simulation stalled %.1f ms%s",
+                "", cacheFormat.c_str(), sequence->nbFrames(), sequence->bytes()*1e-6, sequence->formatTime()*1000.0/nbWritten,
+                sequence->writeTime()*1000.0/nbWritten, sequence->bytes()*1e-6/std::max(exporter->writeTime(), 1e-9), exporter->stallTime()*1000.0,
+                exporter->nbFailed() > 0 ? ", WRITE FAILED" : "");
+            report.push_back(line);
+            nbFailed += exporter->nbFailed() > 0;
+            sim->stopExport();
+        }
+
+        delete sim;
+        for (Mesh *mesh : meshes) delete mesh;
+        delete cloth;
+    }
+    fclose(csv);
+
+    printf("\n---------------- BATCH (%zu scenes, per-frame stats in %s) ----------------\n", scenePaths.size(), statsPath.c_str());
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return nbFailed > 0 ? 1 : 0;
+}
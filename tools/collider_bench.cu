@@ -0,0 +1,120 @@
+#include "../include/bvh4.h"
+#include "../include/analytic_colliders.hcu"
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <random>
+#include <string>
+
+// Sphere + ground scene of main.cu : compares the contact queries of the triangle mesh colliders (BVH4 traversal)
+// with the ones of the analytic colliders, on the CPU.
+// Usage : collider_bench [nbClothVertices]
+
+struct ClothVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+std::vector<ClothVertex> sampleDrapedCloth(glm::vec3 center, float radius, int nbVertices, unsigned int seed)
+{
+    /**
+     * Vertices of a cloth draped over the sphere and resting on the ground around it (half of them each),
+     * slightly above the surfaces, with normals close to the surface's ones
+    */
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> unitDistrib(0.0f, 1.0f);
+
+    std::vector<ClothVertex> cloth;
+    for (int k = 0; k < nbVertices; ++k)
+    {
+        glm::vec3 jitter = 0.2f*glm::vec3(unitDistrib(gen) - 0.5f, unitDistrib(gen) - 0.5f, unitDistrib(gen) - 0.5f);
+        float gap = unitDistrib(gen)*0.8f*HOST_CLOTH_THICKNESS;
+        if (k % 2 == 0)
+        {
+            // upper half of the sphere
+            float th = 2.0f*3.14159265f*unitDistrib(gen);
+            float phi = 0.5f*3.14159265f*unitDistrib(gen);
+            glm::vec3 n = glm::vec3(cos(phi)*cos(th), sin(phi), cos(phi)*sin(th));
+            cloth.push_back(ClothVertex {center + (radius + gap)*n, normalize(n + jitter)});
+        }
+        else
+        {
+            // ground, in a 4 x 4 square around the sphere
+            glm::vec3 p = glm::vec3(center.x + 4.0f*(unitDistrib(gen) - 0.5f), gap, center.z + 4.0f*(unitDistrib(gen) - 0.5f));
+            cloth.push_back(ClothVertex {p, normalize(glm::vec3(0.0f, 1.0f, 0.0f) + jitter)});
+        }
+    }
+    return cloth;
+}
+
+int main(int argc, char **argv)
+{
+    int nbVertices = argc > 1 ? atoi(argv[1]) : 128*128;
+    const int nbRuns = 10;
+
+    // same colliders as main.cu
+    glm::mat4 scaleGround = glm::scale(glm::mat4(1.0f), 3000.0f*glm::vec3(1.0f, 0.0f, 1.0f));
+    glm::mat4 modelGround = glm::translate(glm::mat4(1.0f), -1000.0f*glm::vec3(1.0f, 0.0f, 1.0f))*scaleGround;
+    int groundN = 50;
+    Data groundData = Plane::init_mesh(groundN, modelGround);
+
+    glm::mat4 modelSphere = glm::translate(glm::mat4(1.0f), glm::vec3(2.5f, 1.0f, 2.0f));
+    Data sphereData = Sphere::init_mesh(modelSphere, 1.0f);
+
+    BVH groundBVH(groundData.vertices, groundData.indices);
+    BVH sphereBVH(sphereData.vertices, sphereData.indices);
+    BVH4 ground4(&groundBVH);
+    BVH4 sphere4(&sphereBVH);
+
+    std::vector<AnalyticShape> shapes;
+    shapes.push_back(AnalyticShape::plane(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    shapes.push_back(AnalyticShape::sphere(glm::vec3(modelSphere[3]), 1.0f));
+
+    std::vector<ClothVertex> cloth = sampleDrapedCloth(glm::vec3(modelSphere[3]), 1.0f, nbVertices, 42);
+
+    // mesh colliders : one segment along -n per collider (as CollisionSolver::solve does for the non self colliders)
+    RayQueryStats meshStats = {0, 0, 0};
+    int nbMeshContacts = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < nbRuns; ++run)
+    {
+        nbMeshContacts = 0;
+        for (const ClothVertex &v : cloth)
+        {
+            RayHit hit = {-1, glm::vec4(10e30f)};
+            ground4.intersect(v.position, -v.normal, hit, meshStats);
+            sphere4.intersect(v.position, -v.normal, hit, meshStats);
+            nbMeshContacts += hit.triIdx >= 0;
+        }
+    }
+    std::chrono::duration<double> meshTime = std::chrono::steady_clock::now() - start;
+
+    // analytic colliders : one distance query per shape
+    int nbAnalyticContacts = 0;
+    start = std::chrono::steady_clock::now();
+    for (int run = 0; run < nbRuns; ++run)
+    {
+        nbAnalyticContacts = 0;
+        for (const ClothVertex &v : cloth)
+        {
+            float closestDist = 10e30f;
+            for (const AnalyticShape &shape : shapes)
+            {
+                glm::vec3 closest, n;
+                float d = shapeDistance(shape, v.position, closest, n);
+                if (d <= 0.9f*HOST_CLOTH_THICKNESS) closestDist = std::min(closestDist, std::max(d, 0.0f));
+            }
+            nbAnalyticContacts += closestDist < 10e30f;
+        }
+    }
+    std::chrono::duration<double> analyticTime = std::chrono::steady_clock::now() - start;
+
+    double nbQueries = (double) nbRuns*nbVertices;
+    printf("\n---------------- SPHERE + GROUND (%i cloth vertices, %i runs) ----------------\n", nbVertices, nbRuns);
+    printf("mesh colliders     (%i + %i tris) : %8.2f Mvertices/s, %6.1f nodes/vertex, %6.1f tris/vertex, contacts %i\n",
+        groundBVH.getNbTri(), sphereBVH.getNbTri(), nbQueries/meshTime.count()*1e-6,
+        meshStats.nodesVisited/nbQueries, meshStats.trianglesTested/nbQueries, nbMeshContacts);
+    printf("analytic colliders (%i shapes)         : %8.2f Mvertices/s (x%.2f), contacts %i\n",
+        (int) shapes.size(), nbQueries/analyticTime.count()*1e-6, meshTime.count()/analyticTime.count(), nbAnalyticContacts);
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include "../include/bvh4.h"
+#include "../include/analytic_colliders.hcu"
+#include "../include/clearance.hcu"
+
+#include <vector>
+#include <algorithm>
+
+// Penetration depth and skipped vertex queries of the discrete detection, with a query every substep, with the
+// clearance culling of CollisionSolver::solve (clearance.hcu) and with a fixed collision interval (whose detection reaches
+// further with speculative contacts, to cover the substeps it skips).
+// Scene : a grid of cloth vertices thrown on a ground plane and on a sphere moving towards them.
+// Usage : culling_bench
+
+const float TIME_STEP = 0.0025f;
+const int NB_STEPS = 2000;
+const int GRID = 64;
+
+struct Particle
+{
+    glm::vec3 x;
+    glm::vec3 v;
+    float clearance;
+    glm::vec3 origin; // position the clearance was computed at
+};
+
+struct Result
+{
+    float maxPenetration;
+    long long queries;
+    long long queriesTotal;
+    int substepsDetected;
+};
+
+float sceneDistance(const std::vector<AnalyticShape> &shapes, glm::vec3 p)
+{
+    float d = 1e30f;
+    for (const AnalyticShape &shape : shapes)
+    {
+        glm::vec3 closest, n;
+        d = std::min(d, shapeDistance(shape, p, closest, n));
+    }
+    return d;
+}
+
+void contact(const std::vector<AnalyticShape> &shapes, Particle &particle, float reach, float intervalTime)
+{
+    /**
+     * Discrete detection + response of the solver on the analytic colliders : one contact per shape within 
+     * 0.9*thickness + reach, solved together on the velocity (no approaching velocity, only a limited one for the 
+     * speculative contacts beyond 0.9*thickness), then the vertex is moved slightly above its closest contact
+    */
+    const int CONTACT_ITERATIONS = 8; // (default of SimulationParams::contactIterations)
+    std::vector<glm::vec3> normals, velocities;
+    std::vector<float> targets;
+    float best = 1e30f;
+    glm::vec3 hitPoint, hitNormal;
+    for (const AnalyticShape &shape : shapes)
+    {
+        glm::vec3 closest, n;
+        float d = std::max(shapeDistance(shape, particle.x, closest, n), 0.0f);
+        if (d > 0.9f*HOST_CLOTH_THICKNESS + reach) continue;
+        normals.push_back(n);
+        velocities.push_back(shape.velocity);
+        targets.push_back(d > 0.9f*HOST_CLOTH_THICKNESS ? -speculativeApproach(d - 0.1f*HOST_CLOTH_THICKNESS, intervalTime) : 0.0f);
+        if (d >= best) continue;
+        best = d;
+        hitPoint = closest;
+        hitNormal = n;
+    }
+
+    for (int iteration = 0; iteration < CONTACT_ITERATIONS; ++iteration)
+    {
+        for (int c = 0; c < (int) normals.size(); ++c)
+        {
+            float vN = dot(particle.v - velocities[c], normals[c]);
+            if (vN < targets[c]) particle.v += (targets[c] - vN)*normals[c];
+        }
+    }
+    if (best <= 0.9f*HOST_CLOTH_THICKNESS) particle.x = hitPoint + 0.1f*HOST_CLOTH_THICKNESS*hitNormal;
+}
+
+Result run(bool isCulling, int collisionInterval)
+{
+    std::vector<AnalyticShape> shapes;
+    shapes.push_back(AnalyticShape::plane(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+    shapes.push_back(AnalyticShape::sphere(glm::vec3(6.0f, 1.0f, 1.6f), 1.0f));
+    shapes[1].velocity = glm::vec3(-1.5f, 0.0f, 0.0f);
+
+    std::vector<Particle> particles(GRID*GRID);
+    for (int j = 0; j < GRID; ++j)
+    for (int i = 0; i < GRID; ++i)
+    {
+        Particle &particle = particles[j*GRID + i];
+        particle.x = glm::vec3(0.05f*i, 2.5f + 0.01f*((i*7 + j*13)%17), 0.05f*j);
+        particle.v = glm::vec3(0.0f, -2.0f, 0.0f);
+        particle.clearance = 0.0f;
+        particle.origin = particle.x;
+    }
+
+    Result result = {0.0f, 0, 0, 0};
+    glm::vec3 gravity = glm::vec3(0.0f, -9.81f*0.15f, 0.0f);
+    float travel = 0.0f;
+    bool isClearanceValid = false;
+
+    for (int s = 1; s <= NB_STEPS; ++s)
+    {
+        for (Particle &particle : particles)
+        {
+            particle.v += TIME_STEP*gravity;
+            particle.x += TIME_STEP*particle.v;
+        }
+        shapes[1].p0 += TIME_STEP*shapes[1].velocity;
+
+        for (const Particle &particle : particles)
+            result.maxPenetration = std::max(result.maxPenetration, -sceneDistance(shapes, particle.x));
+        result.queriesTotal += particles.size();
+
+        // same schedule as CollisionSolver::solve
+        float colliderSpeed = 0.0f;
+        for (const AnalyticShape &shape : shapes) colliderSpeed = std::max(colliderSpeed, length(shape.velocity));
+        travel += colliderTravel(colliderSpeed, TIME_STEP);
+        if (!isDetectionScheduled(s, collisionInterval)) continue;
+
+        float clothSpeed = 0.0f;
+        if (collisionInterval > 1) for (const Particle &particle : particles) clothSpeed = std::max(clothSpeed, length(particle.v));
+        float reach = intervalReach(clothSpeed + colliderSpeed, TIME_STEP, collisionInterval);
+
+        long long nbQueries = 0;
+        for (Particle &particle : particles)
+        {
+            if (isCulling)
+            {
+                float c = isClearanceValid ? remainingClearance(particle.clearance, particle.x, particle.origin, travel) : 0.0f;
+                if (c <= HOST_CLOTH_THICKNESS + reach) c = sceneDistance(shapes, particle.x);
+                particle.clearance = c;
+                particle.origin = particle.x;
+                if (c > HOST_CLOTH_THICKNESS + reach) continue;
+            }
+            nbQueries++;
+            contact(shapes, particle, reach, collisionInterval*TIME_STEP);
+        }
+        result.queries += nbQueries;
+        if (nbQueries > 0) result.substepsDetected++;
+        travel = 0.0f;
+        isClearanceValid = true;
+    }
+    return result;
+}
+
+void print(const char *name, Result result)
+{
+    printf("%-28s : max penetration %8.5f | queries skipped %5.1f%% | detection on %4i / %i substeps\n", name,
+        result.maxPenetration, 100.0f*(1.0f - (float) result.queries/(float) result.queriesTotal), result.substepsDetected, NB_STEPS);
+}
+
+int main(int argc, char **argv)
+{
+    printf("\n---------------- DISCRETE DETECTION SCHEDULE (%i vertices, %i substeps of %.4f s) ----------------\n",
+        GRID*GRID, NB_STEPS, TIME_STEP);
+
+    print("every substep", run(false, 1));
+    print("clearance culling", run(true, 1));
+    int intervals[] = {2, 4, 8};
+    for (int interval : intervals)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "interval %i", interval);
+        print(name, run(false, interval));
+        snprintf(name, sizeof(name), "interval %i + culling", interval);
+        print(name, run(true, interval));
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "../include/mesh.hcu"
+#include "../include/mesh_sequence.h"
+
+#include <chrono>
+#include <string>
+
+// PLY / OBJ sequence throughput (see mesh_sequence.h) on a moving cloth : formatting and writing time per frame, against
+// a plain write of the same bytes (the disk's bandwidth), projected to a 10,000 frames sequence.
+// Usage : mesh_sequence_bench [N] [frames] [formatting threads (0 : one per core)] [directory]
+
+void clothFrame(int N, int f, std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals)
+{
+    float t = f/60.0f;
+    float spacing = 4.0f/N;
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            float x = j*spacing;
+            float z = i*spacing;
+            float dx = 0.9f*cos(3.0f*x + 2.0f*t)*cos(2.0f*z + 1.3f*t);
+            float dz = -0.6f*sin(3.0f*x + 2.0f*t)*sin(2.0f*z + 1.3f*t);
+            positions[j*N + i] = glm::vec3(x, 2.0f + 0.3f*sin(3.0f*x + 2.0f*t)*cos(2.0f*z + 1.3f*t), z);
+            normals[j*N + i] = glm::normalize(glm::vec3(-dx, 1.0f, -dz));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int N = argc > 1 ? atoi(argv[1]) : 256;
+    int nbFrames = argc > 2 ? atoi(argv[2]) : 100;
+    int nbThreads = argc > 3 ? atoi(argv[3]) : 0;
+    std::string directory = argc > 4 ? argv[4] : ".";
+    int nbVertices = N*N;
+
+    glm::mat4 model(1.0f);
+    std::vector<GLuint> indices = Plane::init_mesh(N, model).indices;
+    const int nbSourceFrames = 8; // (cycled)
+    std::vector<std::vector<glm::vec3>> positions(nbSourceFrames, std::vector<glm::vec3>(nbVertices));
+    std::vector<std::vector<glm::vec3>> normals(nbSourceFrames, std::vector<glm::vec3>(nbVertices));
+    for (int f = 0; f < nbSourceFrames; ++f) clothFrame(N, f, positions[f], normals[f]);
+
+    std::vector<std::string> report;
+    const char *names[2] = {"ply", "obj"};
+    for (MeshSequenceFormat format : {MESH_SEQUENCE_PLY, MESH_SEQUENCE_OBJ})
+    {
+        MeshSequenceWriter writer(directory + "/mesh_sequence_bench", format, nbVertices, indices, nbThreads);
+        int nbFailed = 0;
+        for (int f = 0; f < nbFrames; ++f)
+        {
+            nbFailed += !writer.writeFrame(f, positions[f % nbSourceFrames].data(), normals[f % nbSourceFrames].data());
+        }
+        size_t frameBytes = writer.bytes()/std::max(writer.nbFrames(), 1);
+
+        // the same bytes, already formatted
+        std::vector<char> buffer(frameBytes, 'x');
+        std::string rawPath = directory + "/mesh_sequence_bench.raw";
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < nbFrames; ++f)
+        {
+            FILE *file = fopen(rawPath.c_str(), "wb");
+            if (!file) break;
+            fwrite(buffer.data(), 1, buffer.size(), file);
+            fclose(file);
+        }
+        std::chrono::duration<double> rawTime = std::chrono::steady_clock::now() - start;
+        remove(rawPath.c_str());
+        for (int f = 0; f < nbFrames; ++f) remove(writer.path(f).c_str());
+
+        double formatTime = writer.formatTime()/nbFrames;
+        double writeTime = writer.writeTime()/nbFrames;
+        double bandwidthTime = rawTime.count()/nbFrames;
+        char line[512];
+        snprintf(line, sizeof(line),
+            "%s : %.2f MB per frame | format %7.2f ms + write %7.2f ms per frame (%7.1f MB/s) | plain write %7.2f ms (%7.1f MB/s) | %s-bound, 10,000 frames in %.0f s%s",
+            names[format], frameBytes*1e-6, formatTime*1000.0, writeTime*1000.0, frameBytes*1e-6/(formatTime + writeTime),
+            bandwidthTime*1000.0, frameBytes*1e-6/bandwidthTime, formatTime > writeTime ? "formatting" : "bandwidth",
+            1e4*(formatTime + writeTime), nbFailed > 0 ? ", WRITE FAILED" : "");
+        report.push_back(line);
+    }
+
+    printf("\n---------------- MESH SEQUENCES (%ix%i cloth, %i frames, %i formatting threads) ----------------\n", N, N, nbFrames,
+        nbThreads > 0 ? nbThreads : std::max(1u, std::thread::hardware_concurrency()));
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
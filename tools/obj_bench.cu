@@ -0,0 +1,45 @@
+#include "../include/mesh.hcu"
+
+#include <string>
+
+// Load time and vertex count of the OBJ loaders : OBJ_Loader (single threaded, one vertex per face corner) vs the
+// multithreaded parser with vertex welding (1 thread, then all threads).
+// Usage : obj_bench [mesh.obj ...]
+
+double loadTime(const std::string &asset, int nbThreads, Data &data)
+{
+    glm::mat4 identity(1.0f);
+    auto start = std::chrono::steady_clock::now();
+    if (nbThreads < 0) data = MeshFromOBJ::init_objl_mesh(identity, asset);
+    else MeshFromOBJ::init_parsed_mesh(identity, asset, data, nbThreads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> assets;
+    for (int i = 1; i < argc; ++i) assets.push_back(argv[i]);
+    if (assets.empty()) assets = {"../assets/heart.obj", "../assets/bed.obj"};
+
+    int nbThreads = std::max(1, (int) std::thread::hardware_concurrency());
+    std::vector<std::string> report;
+    for (const std::string &asset : assets)
+    {
+        Data objl, parsed, parsedMT;
+        double objlTime = loadTime(asset, -1, objl);
+        double parsedTime = loadTime(asset, 1, parsed);
+        double parsedMTTime = loadTime(asset, nbThreads, parsedMT);
+
+        char line[512];
+        snprintf(line, sizeof(line),
+            "%-24s OBJ_Loader %7.1f ms, %7i vertices | parser 1 thread %7.1f ms (x%.1f) | %i threads %7.1f ms (x%.1f), %7i vertices | %i triangles",
+            asset.c_str(), objlTime*1000.0, (int) objl.vertices.size(), parsedTime*1000.0, objlTime/parsedTime,
+            nbThreads, parsedMTTime*1000.0, objlTime/parsedMTTime, (int) parsedMT.vertices.size(), (int) parsedMT.indices.size()/3);
+        report.push_back(line);
+    }
+
+    printf("\n---------------- OBJ LOADING ----------------\n");
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
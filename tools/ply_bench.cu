@@ -0,0 +1,62 @@
+#include "../include/mesh.hcu"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <string>
+
+// Load time and peak resident memory of the PLY loaders : tinyply (file buffer + typed buffers + copies) vs the
+// memory mapped single pass. Each load runs in its own child process so that its peak RSS is measured alone.
+// Usage : ply_bench [mesh.ply ...]
+
+double loadTime(const std::string &asset, bool isMapped, int &nbVertices)
+{
+    glm::mat4 identity(1.0f);
+    auto start = std::chrono::steady_clock::now();
+    Data data;
+    if (isMapped) MeshFromPLY::init_mapped_mesh(identity, asset, data);
+    else data = MeshFromPLY::init_tinyply_mesh(identity, asset);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    nbVertices = data.vertices.size();
+    return elapsed.count();
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> assets;
+    for (int i = 1; i < argc; ++i) assets.push_back(argv[i]);
+    if (assets.empty()) assets = {"../assets/testBuddha.ply", "../assets/bunny.ply", "../assets/sofa.ply"};
+
+    std::vector<std::string> report;
+    for (const std::string &asset : assets)
+    {
+        for (int isMapped = 0; isMapped < 2; ++isMapped)
+        {
+            int pipeFds[2];
+            if (pipe(pipeFds) != 0) return -1;
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                int nbVertices;
+                double time = loadTime(asset, isMapped, nbVertices);
+                char line[512];
+                snprintf(line, sizeof(line), "%-28s %-8s : %8.2f ms, %8i vertices", asset.c_str(), isMapped ? "mapped" : "tinyply",
+                    time*1000.0, nbVertices);
+                if (write(pipeFds[1], line, strlen(line)+1) < 0) _exit(1);
+                _exit(0);
+            }
+
+            close(pipeFds[1]); // a crashed child closes the pipe without writing
+            struct rusage usage;
+            int status;
+            wait4(pid, &status, 0, &usage);
+            char line[512] = "";
+            if (read(pipeFds[0], line, sizeof(line)) <= 0) snprintf(line, sizeof(line), "%-28s failed", asset.c_str());
+            close(pipeFds[0]);
+            report.push_back(std::string(line) + ", peak RSS " + std::to_string(usage.ru_maxrss) + " kB");
+        }
+    }
+
+    printf("\n---------------- PLY LOADING ----------------\n");
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "../include/bvh4.h"
+#include "../include/decimation.h"
+
+#include <random>
+#include <string>
+
+// Full resolution colliders vs their collision proxies (quadric error decimation within a tolerance) : build time,
+// ray-query throughput of the 4-wide BVH on the CPU and deviation of the contact points.
+// Usage : collider meshes are rescaled to a 4 units diagonal (the size of the colliders of the scene)
+//         proxy_bench [tolerance in cloth thicknesses] [mesh.ply|mesh.obj ...]
+
+struct ClothRays
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+};
+
+void normalizeMesh(Data &data, float diagonal)
+{
+    AABB box;
+    for (glm::vec3 &v : data.vertices)
+    {
+        box.aabbMin = min(box.aabbMin, v);
+        box.aabbMax = max(box.aabbMax, v);
+    }
+    glm::vec3 diff = box.aabbMax - box.aabbMin;
+    float scale = diagonal/sqrt(dot(diff, diff));
+    for (glm::vec3 &v : data.vertices) v = (v - box.aabbMin)*scale;
+}
+
+ClothRays sampleClothRays(BVH &bvh, int nbVertices, unsigned int seed)
+{
+    /**
+     * Cloth vertices resting on the full resolution collider, slightly above its surface
+    */
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> triDistrib(0, bvh.getNbTri()-1);
+    std::uniform_real_distribution<float> unitDistrib(0.0f, 1.0f);
+
+    ClothRays rays;
+    for (int k = 0; k < nbVertices; ++k)
+    {
+        Triangle &tri = bvh.tri()[triDistrib(gen)];
+        float u = unitDistrib(gen);
+        float v = unitDistrib(gen);
+        if (u + v > 1.0f)
+        {
+            u = 1.0f - u;
+            v = 1.0f - v;
+        }
+        glm::vec3 n = normalize(tri.normal);
+        rays.positions.push_back(tri.p0 + u*(tri.p1 - tri.p0) + v*(tri.p2 - tri.p0) + 0.5f*HOST_CLOTH_THICKNESS*n);
+        rays.normals.push_back(n);
+    }
+    return rays;
+}
+
+int main(int argc, char **argv)
+{
+    const int nbVertices = 128*128;
+    float tolerance = (argc > 1 ? atof(argv[1]) : PROXY_TOLERANCE)*HOST_CLOTH_THICKNESS;
+    std::vector<std::string> assets;
+    for (int i = 2; i < argc; ++i) assets.push_back(argv[i]);
+    if (assets.empty()) assets = {"../assets/bunny.ply", "../assets/testBuddha.ply", "../assets/bed.obj"};
+
+    glm::mat4 identity(1.0f);
+    std::vector<std::string> report;
+    for (const std::string &asset : assets)
+    {
+        bool isOBJ = asset.size() > 4 && asset.compare(asset.size()-4, 4, ".obj") == 0;
+        Data data = isOBJ ? MeshFromOBJ::init_mesh(identity, asset) : MeshFromPLY::init_mesh(identity, asset);
+        if (data.indices.empty()) continue;
+        normalizeMesh(data, 4.0f);
+
+        auto start = std::chrono::steady_clock::now();
+        BVH bvh(data.vertices, data.indices);
+        std::chrono::duration<double> fullBuild = std::chrono::steady_clock::now() - start;
+        BVH4 bvh4(&bvh);
+
+        start = std::chrono::steady_clock::now();
+        CollisionProxy proxy = decimateMesh(data.vertices, data.indices, 0, tolerance);
+        BVH proxyBVH(proxy.vertices, proxy.indices);
+        std::chrono::duration<double> proxyBuild = std::chrono::steady_clock::now() - start;
+        BVH4 proxy4(&proxyBVH);
+
+        // one segment along -n per vertex, as CollisionSolver::solve
+        ClothRays rays = sampleClothRays(bvh, nbVertices, 42);
+        std::vector<RayHit> hits(nbVertices), proxyHits(nbVertices);
+        start = std::chrono::steady_clock::now();
+        RayQueryStats stats = queryClothRays(&bvh4, rays.positions.data(), rays.normals.data(), nbVertices, hits.data(), 1);
+        std::chrono::duration<double> fullTime = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        RayQueryStats proxyStats = queryClothRays(&proxy4, rays.positions.data(), rays.normals.data(), nbVertices, proxyHits.data(), 1);
+        std::chrono::duration<double> proxyTime = std::chrono::steady_clock::now() - start;
+
+        int nbHits = 0, nbProxyHits = 0;
+        float maxDeviation = 0.0f;
+        for (int v = 0; v < nbVertices; ++v)
+        {
+            nbHits += hits[v].triIdx >= 0;
+            nbProxyHits += proxyHits[v].triIdx >= 0;
+            if (hits[v].triIdx >= 0 && proxyHits[v].triIdx >= 0)
+                maxDeviation = std::max(maxDeviation, length(glm::vec3(hits[v].hitInfo) - glm::vec3(proxyHits[v].hitInfo)));
+        }
+
+        char line[512];
+        snprintf(line, sizeof(line),
+            "%-26s full %8i tris, built in %7.1f ms, %6.2f Mq/s | proxy %7i tris, built in %7.1f ms, %6.2f Mq/s (x%.2f) | hits %i / %i, max deviation %.4f",
+            asset.c_str(), bvh.getNbTri(), fullBuild.count()*1000.0, stats.queries/fullTime.count()*1e-6,
+            proxyBVH.getNbTri(), proxyBuild.count()*1000.0, proxyStats.queries/proxyTime.count()*1e-6, fullTime.count()/proxyTime.count(),
+            nbProxyHits, nbHits, maxDeviation);
+        report.push_back(line);
+    }
+
+    printf("\n---------------- COLLISION PROXIES (tolerance %.4f, %i cloth vertices) ----------------\n", tolerance, nbVertices);
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
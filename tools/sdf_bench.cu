@@ -0,0 +1,123 @@
+#include "../include/bvh4.h"
+#include "../include/sdf.hcu"
+
+#include <random>
+#include <string>
+
+// Static mesh colliders : compares the SDF path (build time, memory, trilinear queries) with the BVH path
+// (binary build, BVH4 ray queries) on the CPU.
+// Usage : sdf_bench [resolution] [nbClothVertices] [mesh.ply ...]
+
+struct ClothVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+};
+
+void normalizeMesh(Data &data, float diagonal)
+{
+    /**
+     * Rescales the mesh so that its bounding box diagonal has the given length (same scale as the simulated scene)
+    */
+    AABB box;
+    for (glm::vec3 &v : data.vertices)
+    {
+        box.aabbMin = min(box.aabbMin, v);
+        box.aabbMax = max(box.aabbMax, v);
+    }
+    glm::vec3 diff = box.aabbMax - box.aabbMin;
+    float scale = diagonal/sqrt(dot(diff, diff));
+    for (glm::vec3 &v : data.vertices) v = (v - box.aabbMin)*scale;
+}
+
+std::vector<ClothVertex> sampleRestingCloth(BVH &bvh, int nbVertices, unsigned int seed)
+{
+    /**
+     * Cloth vertices resting on the collider : random points slightly above its surface
+    */
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> triDistrib(0, bvh.getNbTri()-1);
+    std::uniform_real_distribution<float> unitDistrib(0.0f, 1.0f);
+
+    std::vector<ClothVertex> cloth;
+    for (int k = 0; k < nbVertices; ++k)
+    {
+        Triangle &tri = bvh.tri()[triDistrib(gen)];
+        float u = unitDistrib(gen);
+        float v = unitDistrib(gen);
+        if (u + v > 1.0f)
+        {
+            u = 1.0f - u;
+            v = 1.0f - v;
+        }
+        glm::vec3 n = normalize(tri.normal);
+        glm::vec3 p = tri.p0 + u*(tri.p1 - tri.p0) + v*(tri.p2 - tri.p0) + 0.5f*HOST_CLOTH_THICKNESS*n;
+        cloth.push_back(ClothVertex {p, n});
+    }
+    return cloth;
+}
+
+int main(int argc, char **argv)
+{
+    int resolution = argc > 1 ? atoi(argv[1]) : 64;
+    int nbVertices = argc > 2 ? atoi(argv[2]) : 128*128;
+    std::vector<std::string> assets;
+    for (int i = 3; i < argc; ++i) assets.push_back(argv[i]);
+    if (assets.empty()) assets = {"../assets/bunny.ply", "../assets/elephant.ply", "../assets/testBuddha.ply"};
+
+    glm::mat4 identity(1.0f);
+    std::vector<std::string> report;
+    for (const std::string &asset : assets)
+    {
+        Data data = MeshFromPLY::init_mesh(identity, asset);
+        if (data.indices.empty()) continue;
+        normalizeMesh(data, 4.0f);
+
+        auto start = std::chrono::steady_clock::now();
+        BVH bvh(data.vertices, data.indices);
+        std::chrono::duration<double> bvhTime = std::chrono::steady_clock::now() - start;
+        BVH4 bvh4(&bvh);
+
+        SignedDistanceField sdf(&bvh, resolution, SDF_MIN_BAND, false);
+        std::vector<ClothVertex> cloth = sampleRestingCloth(bvh, nbVertices, 42);
+
+        // BVH path : segments along -n and n
+        RayQueryStats bvhStats = {0, 0, 0};
+        int nbBVHContacts = 0;
+        start = std::chrono::steady_clock::now();
+        for (const ClothVertex &v : cloth)
+        {
+            RayHit hit = {-1, glm::vec4(10e30f)};
+            bvh4.intersect(v.position, -v.normal, hit, bvhStats);
+            bvh4.intersect(v.position, v.normal, hit, bvhStats);
+            nbBVHContacts += hit.triIdx >= 0;
+        }
+        std::chrono::duration<double> bvhQueryTime = std::chrono::steady_clock::now() - start;
+
+        // SDF path : one trilinear lookup
+        int nbSDFContacts = 0;
+        float maxError = 0.0f;
+        start = std::chrono::steady_clock::now();
+        for (const ClothVertex &v : cloth)
+        {
+            glm::vec3 gradient;
+            float d = sdfDistance(sdf.hostGrid(), v.position, gradient);
+            nbSDFContacts += d <= 0.9f*HOST_CLOTH_THICKNESS;
+            maxError = std::max(maxError, fabsf(d - 0.5f*HOST_CLOTH_THICKNESS));
+        }
+        std::chrono::duration<double> sdfQueryTime = std::chrono::steady_clock::now() - start;
+
+        char line[512];
+        snprintf(line, sizeof(line),
+            "%-28s %8i tris | BVH build %7.1f ms, %8.1f kB, %7.2f Mq/s, contacts %i | SDF %i build %8.1f ms, %8.1f kB, %7.2f Mq/s (x%.1f), contacts %i, max error %.4f",
+            asset.c_str(), bvh.getNbTri(),
+            bvhTime.count()*1000.0, bvh.compactMemory()/1000.0f, nbVertices/bvhQueryTime.count()*1e-6, nbBVHContacts,
+            resolution, sdf.buildTime()*1000.0, sdf.memory()/1000.0f, nbVertices/sdfQueryTime.count()*1e-6,
+            bvhQueryTime.count()/sdfQueryTime.count(), nbSDFContacts, maxError);
+        report.push_back(line);
+    }
+
+    printf("\n---------------- STATIC COLLIDERS (%i cloth vertices) ----------------\n", nbVertices);
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
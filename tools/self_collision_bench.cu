@@ -0,0 +1,79 @@
+#include "../include/self_collision.hcu"
+
+#include <chrono>
+#include <string>
+
+// Self collision cost against the cloth resolution : a folded cloth (two layers closer than the self collision
+// thickness) solved repeatedly on the GPU. The cell table is built by a counting sort, so the time per vertex should
+// stay flat and the time per solve should grow like the number of vertices (x4 when N doubles).
+// Usage : self_collision_bench [nbSolves]
+
+const float REST_LENGTH = 0.01f;
+
+std::vector<glm::vec3> foldedCloth(int N, float restLength)
+{
+    /**
+     * Grid of N x N vertices folded in half along j : the second half lies 0.4 rest lengths above the first one
+    */
+    std::vector<glm::vec3> positions(N*N);
+    for (int j = 0; j < N; ++j)
+    {
+        int row = j < N/2 ? j : N-1 - j;
+        float height = j < N/2 ? 0.0f : 0.4f*restLength;
+        for (int i = 0; i < N; ++i) positions[j*N + i] = glm::vec3(i*restLength, height, row*restLength);
+    }
+    return positions;
+}
+
+int main(int argc, char **argv)
+{
+    int nbSolves = argc > 1 ? atoi(argv[1]) : 20;
+    int resolutions[] = {128, 256, 512, 1024};
+
+    std::vector<std::string> report;
+    double prevTime = 0.0;
+    for (int N : resolutions)
+    {
+        int nbVertices = N*N;
+        std::vector<glm::vec3> hostPositions = foldedCloth(N, REST_LENGTH);
+
+        glm::vec3 *positions, *velocities;
+        unsigned long long *nbContacts;
+        cudaErrorCheck(cudaMalloc((void **) &positions, sizeof(glm::vec3)*nbVertices));
+        cudaErrorCheck(cudaMalloc((void **) &velocities, sizeof(glm::vec3)*nbVertices));
+        cudaErrorCheck(cudaMalloc((void **) &nbContacts, sizeof(unsigned long long)));
+
+        SelfCollision selfCollision(N, REST_LENGTH);
+        double totalTime = 0.0;
+        unsigned long long contacts = 0;
+        for (int k = 0; k < nbSolves + 1; ++k)
+        {
+            // same input at every solve : the response moves the layers apart
+            cudaErrorCheck(cudaMemcpy(positions, hostPositions.data(), sizeof(glm::vec3)*nbVertices, cudaMemcpyHostToDevice));
+            cudaErrorCheck(cudaMemset(velocities, 0, sizeof(glm::vec3)*nbVertices));
+            cudaErrorCheck(cudaMemset(nbContacts, 0, sizeof(unsigned long long)));
+
+            auto start = std::chrono::steady_clock::now();
+            selfCollision.solve(positions, velocities, nbContacts);
+            std::chrono::duration<double> solveTime = std::chrono::steady_clock::now() - start;
+            if (k == 0) continue; // warm up (allocations of thrust's scan)
+            totalTime += solveTime.count();
+        }
+        cudaErrorCheck(cudaMemcpy(&contacts, nbContacts, sizeof(unsigned long long), cudaMemcpyDeviceToHost));
+
+        cudaErrorCheck(cudaFree(positions));
+        cudaErrorCheck(cudaFree(velocities));
+        cudaErrorCheck(cudaFree(nbContacts));
+
+        double solveTime = totalTime/nbSolves;
+        char line[256];
+        snprintf(line, sizeof(line), "N = %4i : %8i vertices, %9llu contacts | %8.3f ms / solve, %6.2f ns / vertex, x%.2f",
+            N, nbVertices, contacts, solveTime*1000.0, solveTime/nbVertices*1e9, prevTime > 0.0 ? solveTime/prevTime : 1.0);
+        report.push_back(line);
+        prevTime = solveTime;
+    }
+
+    printf("\n---------------- SELF COLLISION (%i solves per resolution) ----------------\n", nbSolves);
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "../include/frame_export.hcu"
+#include "../include/vertex_cache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// PC2 / MDD export throughput (see vertex_cache.h) : writer alone, then fed by the exporter thread from a device buffer
+// at a fixed frame rate, as the simulation does : cost of the snapshot in the step loop and stalls when the disk
+// falls behind. Usage : vertex_cache_bench [N] [frames] [fps]
+
+void clothFrame(int N, int f, std::vector<glm::vec3> &positions)
+{
+    float t = f/60.0f;
+    float spacing = 4.0f/N;
+    for (int j = 0; j < N; ++j)
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            float x = j*spacing;
+            float z = i*spacing;
+            positions[j*N + i] = glm::vec3(x, 2.0f + 0.3f*sin(3.0f*x + 2.0f*t)*cos(2.0f*z + 1.3f*t), z);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int N = argc > 1 ? atoi(argv[1]) : 512;
+    int nbFrames = argc > 2 ? atoi(argv[2]) : 300;
+    float fps = argc > 3 ? atof(argv[3]) : 60.0f;
+    int nbVertices = N*N;
+    double frameMB = sizeof(glm::vec3)*nbVertices*1e-6;
+
+    const int nbSourceFrames = 8; // (cycled)
+    std::vector<std::vector<glm::vec3>> frames(nbSourceFrames, std::vector<glm::vec3>(nbVertices));
+    for (int f = 0; f < nbSourceFrames; ++f) clothFrame(N, f, frames[f]);
+    glm::vec3 *positionsCuda;
+    cudaErrorCheck(cudaMalloc((void **) &positionsCuda, sizeof(glm::vec3)*nbVertices));
+
+    std::vector<std::string> report;
+    const char *names[2] = {"pc2", "mdd"};
+    for (VertexCacheFormat format : {VERTEX_CACHE_PC2, VERTEX_CACHE_MDD})
+    {
+        std::string path = std::string("vertex_cache_bench.") + names[format];
+
+        // writer alone (from host memory)
+        auto start = std::chrono::steady_clock::now();
+        {
+            VertexCacheWriter writer(path, format, nbVertices, fps, 0, nbFrames-1);
+            for (int f = 0; f < nbFrames; ++f) writer.writeFrame(f, frames[f % nbSourceFrames].data());
+        }
+        std::chrono::duration<double> directTime = std::chrono::steady_clock::now() - start;
+
+        // exporter fed at fps
+        VertexCacheWriter *writer = new VertexCacheWriter(path, format, nbVertices, fps, 0, nbFrames-1);
+        FrameExporter *exporter = new FrameExporter(nbVertices, [writer](int frame, const glm::vec3 *positions, int nb)
+        {
+            return writer->writeFrame(frame, positions);
+        });
+        std::vector<double> snapshotTimes(nbFrames);
+        auto frameStart = std::chrono::steady_clock::now();
+        for (int f = 0; f < nbFrames; ++f)
+        {
+            // (stands for the step : new positions in the cloth's buffer)
+            cudaErrorCheck(cudaMemcpy(positionsCuda, frames[f % nbSourceFrames].data(), sizeof(glm::vec3)*nbVertices, cudaMemcpyHostToDevice));
+            start = std::chrono::steady_clock::now();
+            exporter->snapshot(positionsCuda, f);
+            snapshotTimes[f] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            frameStart += std::chrono::microseconds((long long) (1e6/fps));
+            std::this_thread::sleep_until(frameStart);
+        }
+        exporter->flush();
+        std::sort(snapshotTimes.begin(), snapshotTimes.end());
+
+        char line[512];
+        snprintf(line, sizeof(line),
+            "%s : writer %7.1f MB/s (%6.1f frames/s) | at %.0f fps : writer %7.1f MB/s busy %4.1f%%, snapshot median %.3f ms max %.3f, stalled %.1f ms, %i failed",
+            names[format], nbFrames*frameMB/directTime.count(), nbFrames/directTime.count(), fps,
+            nbFrames*frameMB/std::max(exporter->writeTime(), 1e-9), 100.0*exporter->writeTime()*fps/nbFrames,
+            snapshotTimes[nbFrames/2], snapshotTimes.back(), exporter->stallTime()*1000.0, exporter->nbFailed());
+        report.push_back(line);
+        delete exporter;
+        delete writer;
+        remove(path.c_str());
+    }
+    cudaErrorCheck(cudaFree(positionsCuda));
+
+    printf("\n---------------- VERTEX CACHES (%ix%i cloth : %.2f MB per frame, %i frames) ----------------\n", N, N, frameMB, nbFrames);
+    for (const std::string &line : report) printf("%s\n", line.c_str());
+    return 0;
+}